@@ -0,0 +1,110 @@
+/*-
+ * Copyright (c) 2019 Rui Liu and Dominique Li <dominique.li@univ-tours.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id: log.h 998 2014-12-18 12:07:14Z li $
+ */
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include "sdis-mmap.h"
+#include "sdis-stream.h"
+#include "timer.h"
+using namespace sdistream;
+
+// Parse a whole stream, keep the parsed tuples if required.
+template<class IN>
+auto parse_stream(IN &in, size_t width, std::vector<value_t> *tuples) -> size_t {
+  std::vector<value_t> buffer(width, 0);
+  size_t count = 0;
+  while (input(in, width, buffer.data())) {
+    if (tuples) {
+      tuples->insert(tuples->end(), buffer.begin(), buffer.end());
+    }
+    ++count;
+  }
+  return count;
+}
+
+auto main(int argc, char **argv) -> int {
+  if (argc < 3) {
+    std::cout << "Usage: bench-input DIMENSIONALITY STREAM [REPEAT]" << std::endl;
+    return 0;
+  }
+  size_t width = strtoul(argv[1], nullptr, 10);
+  const char *stream = argv[2];
+  size_t repeat = argc > 3 ? strtoul(argv[3], nullptr, 10) : 5;
+  if (width == 0 || repeat == 0) {
+    std::cerr << "Invalid dimensionality or repeat count" << std::endl;
+    return 1;
+  }
+  std::vector<value_t> tuples_istream;
+  std::vector<value_t> tuples_mmap;
+  size_t count_istream = 0;
+  size_t count_mmap = 0;
+  size_t bytes = 0;
+  double best_istream = 0;
+  double best_mmap = 0;
+  for (size_t r = 0; r < repeat; ++r) {
+    std::ifstream in(stream);
+    if (!in.good()) {
+      std::cerr << "Cannot open stream " << stream << std::endl;
+      return 1;
+    }
+    double start = timer::microtime();
+    count_istream = parse_stream(in, width, r ? nullptr : &tuples_istream);
+    double elapsed = timer::microtime() - start;
+    if (!r || elapsed < best_istream) {
+      best_istream = elapsed;
+    }
+  }
+  for (size_t r = 0; r < repeat; ++r) {
+    double start = timer::microtime();
+    csv_stream in;
+    if (!in.open(stream)) {
+      std::cerr << "Cannot map stream " << stream << std::endl;
+      return 1;
+    }
+    count_mmap = parse_stream(in, width, r ? nullptr : &tuples_mmap);
+    bytes = in.size();
+    in.close();
+    double elapsed = timer::microtime() - start;
+    if (!r || elapsed < best_mmap) {
+      best_mmap = elapsed;
+    }
+  }
+  bool identical = count_istream == count_mmap && tuples_istream.size() == tuples_mmap.size()
+      && std::memcmp(tuples_istream.data(), tuples_mmap.data(), sizeof(value_t) * tuples_istream.size()) == 0;
+  double mb = bytes / 1048576.0;
+  std::cout << "# reader tuples seconds MB/s ns/tuple" << std::endl;
+  std::cout << "istream " << count_istream << " " << best_istream << " " << (best_istream > 0 ? mb / best_istream : 0)
+            << " " << (count_istream ? best_istream * 1e9 / count_istream : 0) << std::endl;
+  std::cout << "mmap " << count_mmap << " " << best_mmap << " " << (best_mmap > 0 ? mb / best_mmap : 0) << " "
+            << (count_mmap ? best_mmap * 1e9 / count_mmap : 0) << std::endl;
+  std::cout << "# Speedup: " << (best_mmap > 0 ? best_istream / best_mmap : 0) << std::endl;
+  std::cout << "# Identical: " << (identical ? "yes" : "no") << std::endl;
+  return identical ? 0 : 1;
+}
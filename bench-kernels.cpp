@@ -0,0 +1,277 @@
+/*-
+ * Copyright (c) 2019 Rui Liu and Dominique Li <dominique.li@univ-tours.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id: log.h 998 2014-12-18 12:07:14Z li $
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "sdis-bound.h"
+#include "sdis-cache.h"
+#include "sdis-dominance.h"
+#include "sdis-index.h"
+#include "sdis-skyline.h"
+#include "timer.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+using namespace sdistream;
+
+#ifndef KERNEL_POOL
+#define KERNEL_POOL 1024
+#endif
+
+// Time stamp counter, 0 where there is none.
+static inline auto ticks() -> uint64_t {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+static volatile size_t result;
+
+static const char *KERNELS[] = {"scalar", "sse2", "avx2", "avx512"};
+
+// Run a kernel over the argument pool, keep the best of repeated runs.
+template<class F>
+static void measure(const char *kernel, size_t width, const char *kind, size_t scanned, size_t calls, size_t repeat,
+                    F f) {
+  double best_ns = 0;
+  double best_cycles = 0;
+  for (size_t r = 0; r < repeat; ++r) {
+    size_t sum = 0;
+    auto start = timer::nanotime();
+    auto tick = ticks();
+    for (size_t i = 0; i < calls; ++i) {
+      sum += f(i % KERNEL_POOL);
+    }
+    double cycles = ticks() - tick;
+    double ns = timer::nanotime() - start;
+    result = sum;
+    if (!r || ns < best_ns) {
+      best_ns = ns;
+      best_cycles = cycles;
+    }
+  }
+  std::cout << kernel << " " << width << " " << kind << " " << best_ns / calls << " " << best_cycles / calls << " "
+            << best_cycles / calls / scanned << std::endl;
+}
+
+// Pairs of tuples where the first one is worse on the first dimension, or
+// dominates the second one only after all dimensions are compared.
+static void fill(std::mt19937_64 &random, size_t width, bool full, std::vector<value_t> &a, std::vector<value_t> &b) {
+  std::uniform_real_distribution<double> uniform(0, 1);
+  a.resize(KERNEL_POOL * width);
+  b.resize(KERNEL_POOL * width);
+  for (size_t i = 0; i < KERNEL_POOL * width; ++i) {
+    a[i] = uniform(random);
+    b[i] = full ? a[i] + (i % width == width - 1 ? 1 : 0) : a[i] - (i % width ? 0 : 1);
+  }
+}
+
+// Compare the supported dominance kernels with the scalar one on rows of
+// ties, signed zeros and NaN, and batch kernels with row tests.
+static auto identical(std::mt19937_64 &random) -> bool {
+  const value_t values[] = {-1, -0.0, 0.0, 1, 2, NAN};
+  std::vector<value_t> a(64);
+  std::vector<value_t> b(64);
+  bool same = true;
+  for (size_t n = 0; n < 100000 && same; ++n) {
+    size_t width = 1 + n % 33;
+    for (size_t i = 0; i < width; ++i) {
+      a[i] = values[random() % 6];
+      b[i] = random() % 4 ? a[i] : values[random() % 6];
+    }
+    dominance::select("scalar");
+    bool expected = dominance::test(a.data(), b.data(), width);
+    for (auto &&name : KERNELS) {
+      if (dominance::select(name) && dominance::test(a.data(), b.data(), width) != expected) {
+        std::cerr << "Kernel " << name << " differs at dimensionality " << width << std::endl;
+        same = false;
+      }
+    }
+  }
+  std::vector<value_t> columns(200 * 8);
+  std::vector<value_t> row(8);
+  std::vector<uint64_t> mask(4);
+  for (size_t n = 0; n < 10000 && same; ++n) {
+    size_t width = 1 + n % 8;
+    size_t count = 1 + random() % 200;
+    for (size_t i = 0; i < width; ++i) {
+      a[i] = values[random() % 6];
+      for (size_t p = 0; p < count; ++p) {
+        columns[i * 200 + p] = random() % 2 ? a[i] : values[random() % 6];
+      }
+    }
+    // The latest dominating point, or the dominated points.
+    dominance::select("scalar");
+    size_t expected = count;
+    std::vector<uint64_t> bits(4, 0);
+    for (size_t p = count; p-- > 0 && expected == count;) {
+      for (size_t i = 0; i < width; ++i) {
+        row[i] = columns[i * 200 + p];
+      }
+      if (dominance::test(row.data(), a.data(), width)) {
+        expected = p;
+      } else if (dominance::test(a.data(), row.data(), width)) {
+        bits[p / 64] |= uint64_t(1) << (p % 64);
+      }
+    }
+    for (auto &&name : KERNELS) {
+      if (!dominance::select(name)) {
+        continue;
+      }
+      auto last = dominance::batch(columns.data(), 200, count, width, a.data(), mask.data());
+      if (last != expected || (last == count && !std::equal(bits.begin(), bits.begin() + (count + 63) / 64,
+                                                                mask.begin()))) {
+        std::cerr << "Batch kernel " << name << " differs at dimensionality " << width << std::endl;
+        same = false;
+      }
+    }
+  }
+  dominance::select(nullptr);
+  return same;
+}
+
+auto main(int argc, char **argv) -> int {
+  size_t calls = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1000000;
+  size_t repeat = argc > 2 ? strtoul(argv[2], nullptr, 10) : 5;
+  if (calls == 0 || repeat == 0) {
+    std::cout << "Usage: bench-kernels [CALLS] [REPEAT]" << std::endl;
+    return 0;
+  }
+  std::mt19937_64 random(1);
+  std::uniform_real_distribution<double> uniform(0, 1);
+  bool same = identical(random);
+  std::cout << "# Dominance kernel: " << dominance::name() << std::endl;
+  std::cout << "# kernel dimensionality case ns/call cycles/call cycles/dimension" << std::endl;
+  for (size_t width : {2, 4, 8, 16, 32}) {
+    for (bool full : {false, true}) {
+      auto kind = full ? "full" : "exit";
+      size_t scanned = full ? width : 1;
+      std::vector<value_t> a;
+      std::vector<value_t> b;
+      fill(random, width, full, a, b);
+      // Row-major tuples of the rss engines.
+      measure("dominate<value_t>", width, kind, scanned, calls, repeat, [&](size_t i) {
+        return dominate<value_t>(&a[i * width], &b[i * width], width);
+      });
+      for (auto &&name : KERNELS) {
+        if (dominance::select(name)) {
+          auto kernel = std::string("dominance::") + name;
+          measure(kernel.c_str(), width, kind, scanned, calls, repeat, [&](size_t i) {
+            return dominance::test(&a[i * width], &b[i * width], width);
+          });
+        }
+      }
+      dominance::select(nullptr);
+      // One tuple against the second tuples stored column-wise: the last
+      // point dominates the tuple, or the tuple dominates all points.
+      std::vector<value_t> columns(KERNEL_POOL * width);
+      for (size_t p = 0; p < KERNEL_POOL; ++p) {
+        for (size_t i = 0; i < width; ++i) {
+          columns[i * KERNEL_POOL + p] = b[p * width + i];
+        }
+      }
+      std::vector<value_t> least(width, -1);
+      auto tuple = full ? least.data() : &a[(KERNEL_POOL - 1) * width];
+      std::vector<uint64_t> mask(KERNEL_POOL / 64);
+      for (auto &&name : KERNELS) {
+        if (dominance::select(name)) {
+          auto kernel = std::string("dominance::batch/") + name;
+          measure(kernel.c_str(), width, kind, full ? KERNEL_POOL * width : width, calls / KERNEL_POOL + 1, repeat,
+                  [&](size_t) {
+                    return dominance::batch(columns.data(), KERNEL_POOL, KERNEL_POOL, width, tuple, mask.data());
+                  });
+        }
+      }
+      dominance::select(nullptr);
+      // Rows of the rssi index, a window holding the a, b and probe rows.
+      class index index(nullptr, width, 3 * KERNEL_POOL);
+      std::vector<index::header *> ha;
+      std::vector<index::header *> hb;
+      for (size_t i = 0; i < KERNEL_POOL; ++i) {
+        ha.push_back(index.put(&a[i * width]));
+        hb.push_back(index.put(&b[i * width]));
+      }
+      measure("index::dominate(header,header)", width, kind, scanned, calls, repeat, [&](size_t i) {
+        return index.dominate(ha[i], hb[i]);
+      });
+      measure("index::dominate(header,buffer)", width, kind, scanned, calls, repeat, [&](size_t i) {
+        return index.dominate(ha[i], &b[i * width]);
+      });
+      measure("index::dominate(buffer,header)", width, kind, scanned, calls, repeat, [&](size_t i) {
+        return index.dominate(&a[i * width], hb[i]);
+      });
+      // Dimension estimators: the lowest value of the first dimension stops
+      // at the first dimension, values inside the range estimate all of them.
+      std::vector<btree<entry>> bounds(width);
+      std::vector<btree<cache_entry>> caches(width);
+      for (size_t i = 0; i < KERNEL_POOL; ++i) {
+        for (size_t d = 0; d < width; ++d) {
+          auto v = uniform(random);
+          bounds[d].insert(entry(i, v));
+          caches[d].insert(cache_entry(i, v));
+        }
+      }
+      std::vector<entry> eb(KERNEL_POOL * width);
+      std::vector<cache_entry> ec(KERNEL_POOL * width);
+      std::vector<value_t> probe(KERNEL_POOL * width);
+      for (size_t i = 0; i < KERNEL_POOL * width; ++i) {
+        probe[i] = !full && i % width == 0 ? -1 : 0.25 + 0.5 * uniform(random);
+        eb[i] = entry(KERNEL_POOL + i, probe[i]);
+        ec[i] = cache_entry(KERNEL_POOL + i, probe[i]);
+      }
+      std::vector<index::header *> hp;
+      for (size_t i = 0; i < KERNEL_POOL; ++i) {
+        hp.push_back(index.put(&probe[i * width]));
+      }
+      measure("estimate(entry)", width, kind, 1, calls, repeat, [&](size_t i) {
+        return (size_t) (estimate(eb[i * width], bounds[0]) * 1024);
+      });
+      measure("estimate(cache_entry)", width, kind, 1, calls, repeat, [&](size_t i) {
+        return (size_t) (estimate(ec[i * width], caches[0]) * 1024);
+      });
+      measure("lower_dimension(entry)", width, kind, scanned, calls, repeat, [&](size_t i) {
+        return lower_dimension(&eb[i * width], bounds.data(), width);
+      });
+      measure("lower_dimension(cache_entry)", width, kind, scanned, calls, repeat, [&](size_t i) {
+        return lower_dimension(&ec[i * width], caches.data(), width);
+      });
+      measure("index::lower(header)", width, kind, scanned, calls, repeat, [&](size_t i) {
+        return index.lower(hp[i]);
+      });
+    }
+  }
+  std::cout << "# Identical: " << (same ? "yes" : "no") << std::endl;
+  return same ? 0 : 1;
+}
@@ -0,0 +1,78 @@
+#!/bin/sh
+# Run rss-count, rssi-count, rss-time and rssi-time over a grid of
+# distributions, dimensionalities and windows, and write one CSV line per run.
+#
+# Usage: bench.sh [BINDIR] [RESULTS]
+#
+# BINDIR holds the binaries and generate (default bin), RESULTS defaults to
+# the standard output. The grid is read from the environment:
+#   DISTRIBUTIONS  generator distributions (default: all of them)
+#   DIMENSIONS     dimensionalities (default "2 4 8")
+#   WINDOWS        count windows in tuples (default "1000 10000")
+#   TIME_WINDOWS   time windows in seconds, replayed in real time (default "1")
+#   RATE           arrival rate of time windows in tuples/sec (default 2000)
+#   POST           tuples processed once a window is filled, POST_WINDOW_COUNT of
+#                  the binaries (default 2000)
+#   SEED           generator seed (default 1)
+
+BIN=${1:-bin}
+RESULTS=${2:-/dev/stdout}
+DISTRIBUTIONS=${DISTRIBUTIONS:-"independent correlated anti-correlated clustered duplicate"}
+DIMENSIONS=${DIMENSIONS:-"2 4 8"}
+WINDOWS=${WINDOWS:-"1000 10000"}
+TIME_WINDOWS=${TIME_WINDOWS:-"1"}
+RATE=${RATE:-2000}
+POST=${POST:-2000}
+SEED=${SEED:-1}
+
+for b in generate rss-count rssi-count rss-time rssi-time; do
+  if [ ! -x "$BIN/$b" ]; then
+    echo "Missing $BIN/$b" >&2
+    exit 1
+  fi
+done
+
+DATA=$(mktemp -d "${TMPDIR:-/tmp}/sdis-bench.XXXXXX") || exit 1
+trap 'rm -rf "$DATA"' EXIT INT TERM
+
+# Run ENGINE DISTRIBUTION DIMENSIONALITY WINDOW STREAM and print its CSV line.
+run() {
+  "$BIN/$1" -s null -r 0 "$3" "$4" "$5" 2>/dev/null | awk -v engine="$1" -v dist="$2" -v d="$3" -v w="$4" '
+    $2 == "Latency" && $4 == "all:" {
+      for (i = 5; i <= NF; ++i) {
+        split($i, kv, "=")
+        lat[kv[1]] = kv[2]
+      }
+    }
+    $2 == "Mean" { mean = $5 }
+    $2 == "Dominance" { dt = $4; sub(",", "", dt); skyline = $7 }
+    $2 == "Peak" { rss = $4 }
+    END {
+      printf "%s,%s,%s,%s,%s,%.0f,%s,%s,%s,%s,%s,%s,%s,%s,%s\n", engine, dist, d, w, lat["n"],
+             (mean > 0 ? 1 / mean : 0), lat["mean"], lat["p50"], lat["p90"], lat["p99"], lat["p99.9"], lat["max"],
+             dt, skyline, rss
+    }'
+}
+
+echo "engine,distribution,dimensionality,window,tuples,throughput,mean_ns,p50_ns,p90_ns,p99_ns,p999_ns,max_ns,dt,skyline,peak_rss_kib" > "$RESULTS"
+for dist in $DISTRIBUTIONS; do
+  for d in $DIMENSIONS; do
+    for w in $WINDOWS; do
+      stream="$DATA/$dist-$d-$w.bin"
+      "$BIN/generate" -b -s "$SEED" "$dist" "$d" $((w + POST + 1)) "$stream" 2>/dev/null || exit 1
+      for engine in rss-count rssi-count; do
+        run $engine "$dist" "$d" "$w" "$stream" >> "$RESULTS"
+      done
+      rm -f "$stream"
+    done
+    for w in $TIME_WINDOWS; do
+      stream="$DATA/$dist-$d-t$w.bin"
+      length=$(awk -v w="$w" -v r="$RATE" -v p="$POST" 'BEGIN { printf "%d", (w * r + p) * 1.2 + 1 }')
+      "$BIN/generate" -b -r "$RATE" -s "$SEED" "$dist" "$d" "$length" "$stream" 2>/dev/null || exit 1
+      for engine in rss-time rssi-time; do
+        run $engine "$dist" "$d" "$w" "$stream" >> "$RESULTS"
+      done
+      rm -f "$stream"
+    done
+  done
+done
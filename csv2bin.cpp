@@ -0,0 +1,91 @@
+/*-
+ * Copyright (c) 2019 Rui Liu and Dominique Li <dominique.li@univ-tours.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id: log.h 998 2014-12-18 12:07:14Z li $
+ */
+
+#include <unistd.h>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include "sdis-mmap.h"
+using namespace sdistream;
+
+auto usage() -> int {
+  std::cout << "Usage: csv2bin [-t] DIMENSIONALITY CSV BINARY" << std::endl;
+  std::cout << "  -t  The first field of each line is a timestamp in seconds" << std::endl;
+  return 0;
+}
+
+auto main(int argc, char **argv) -> int {
+  bool timed = false;
+  int c;
+  while ((c = getopt(argc, argv, "t")) != -1) {
+    if (c == 't') {
+      timed = true;
+    } else {
+      return usage();
+    }
+  }
+  if (argc - optind < 3) {
+    return usage();
+  }
+  size_t dimensionality = strtoul(argv[optind], nullptr, 10);
+  const char *source = argv[optind + 1];
+  const char *target = argv[optind + 2];
+  if (dimensionality == 0) {
+    std::cerr << "Invalid dimensionality" << std::endl;
+    return 1;
+  }
+  csv_stream in;
+  if (!in.open(source)) {
+    std::cerr << "Cannot open stream " << source << std::endl;
+    return 1;
+  }
+  std::ofstream out(target, std::ios::binary | std::ios::trunc);
+  if (!out.good()) {
+    std::cerr << "Cannot create stream " << target << std::endl;
+    return 1;
+  }
+  binary_header header;
+  header.width = (uint32_t) dimensionality;
+  header.flags = timed ? binary_header::TIMESTAMP : 0;
+  out.write((const char *) &header, sizeof(header));
+  size_t stride = dimensionality + (timed ? 1 : 0);
+  std::vector<value_t> row(stride, 0);
+  while (in.read(stride, row.data())) {
+    out.write((const char *) row.data(), sizeof(value_t) * stride);
+    ++header.count;
+  }
+  out.seekp(0);
+  out.write((const char *) &header, sizeof(header));
+  out.close();
+  if (!out.good()) {
+    std::cerr << "Cannot write stream " << target << std::endl;
+    return 1;
+  }
+  std::cerr << header.count << " tuples written" << std::endl;
+  return 0;
+}
@@ -0,0 +1,304 @@
+/*-
+ * Copyright (c) 2019 Rui Liu and Dominique Li <dominique.li@univ-tours.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id: log.h 998 2014-12-18 12:07:14Z li $
+ */
+
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "sdis-mmap.h"
+using namespace sdistream;
+
+// Seeded tuples of the usual skyline benchmark distributions in the unit
+// hypercube. Correlated and anti-correlated tuples follow Borzsonyi et al.,
+// The Skyline Operator, ICDE 2001.
+class generator {
+public:
+  enum distribution {
+    INDEPENDENT, // Uniform values.
+    CORRELATED, // Values close to a random point of the diagonal.
+    ANTI_CORRELATED, // Values close to the plane orthogonal to the diagonal.
+    CLUSTERED, // Gaussian clusters around K uniform centers.
+    DUPLICATE, // Uniform values rounded to K levels per dimension.
+    DISTRIBUTIONS
+  };
+  static const char *NAMES[DISTRIBUTIONS];
+  generator(distribution d, size_t width, size_t k, uint64_t seed) : d_(d), width_(width), k_(k), random_(seed) {
+    for (size_t i = 0; i < k_ * width_ && d_ == CLUSTERED; ++i) {
+      centers_.push_back(uniform_());
+    }
+  }
+  // Find a distribution by name or by a prefix of at least three letters.
+  static auto find(const char *name, distribution &d) -> bool {
+    for (size_t i = 0; i < DISTRIBUTIONS; ++i) {
+      if (!strcmp(name, NAMES[i]) || (strlen(name) >= 3 && !strncmp(name, NAMES[i], strlen(name)))) {
+        d = (distribution) i;
+        return true;
+      }
+    }
+    return false;
+  }
+  // Generate the next tuple.
+  void next(value_t *tuple) {
+    switch (d_) {
+      case CORRELATED:
+        do {
+          auto v = peak_(0, 1, width_);
+          auto l = v <= 0.5 ? v : 1 - v;
+          shift_(tuple, v, l, true);
+        } while (!valid_(tuple));
+        break;
+      case ANTI_CORRELATED:
+        do {
+          auto v = peak_(0.25, 0.75, 12);
+          auto l = v <= 0.5 ? v : 1 - v;
+          shift_(tuple, v, l, false);
+        } while (!valid_(tuple));
+        break;
+      case CLUSTERED: {
+        auto center = &centers_[(size_t) (uniform_() * k_) % k_ * width_];
+        do {
+          for (size_t i = 0; i < width_; ++i) {
+            tuple[i] = center[i] + normal_(random_);
+          }
+        } while (!valid_(tuple));
+        break;
+      }
+      case DUPLICATE:
+        for (size_t i = 0; i < width_; ++i) {
+          tuple[i] = (value_t) (size_t) (uniform_() * k_) / k_;
+        }
+        break;
+      default:
+        for (size_t i = 0; i < width_; ++i) {
+          tuple[i] = uniform_();
+        }
+    }
+  }
+  // Draw an exponential inter-arrival time at a rate.
+  auto arrival(double rate) -> double {
+    return std::exponential_distribution<double>(rate)(random_);
+  }
+private:
+  inline auto uniform_() -> double {
+    return std::uniform_real_distribution<double>(0, 1)(random_);
+  }
+  // A bell-shaped value in [min, max], the mean of n uniform values.
+  inline auto peak_(double min, double max, size_t n) -> double {
+    double sum = 0;
+    for (size_t i = 0; i < n; ++i) {
+      sum += uniform_();
+    }
+    return min + (max - min) * sum / n;
+  }
+  // Start from v on all dimensions and move pairs of dimensions in opposite
+  // directions by at most l, keeping the sum of values.
+  inline void shift_(value_t *tuple, double v, double l, bool bell) {
+    for (size_t i = 0; i < width_; ++i) {
+      tuple[i] = v;
+    }
+    for (size_t i = 0; i < width_; ++i) {
+      auto h = bell ? peak_(-l, l, 12) : -l + 2 * l * uniform_();
+      tuple[i] += h;
+      tuple[(i + 1) % width_] -= h;
+    }
+  }
+  inline auto valid_(const value_t *tuple) const -> bool {
+    for (size_t i = 0; i < width_; ++i) {
+      if (tuple[i] < 0 || tuple[i] >= 1) {
+        return false;
+      }
+    }
+    return true;
+  }
+  distribution d_;
+  size_t width_;
+  size_t k_;
+  std::mt19937_64 random_;
+  std::normal_distribution<double> normal_{0, 0.05};
+  std::vector<double> centers_;
+};
+
+const char *generator::NAMES[generator::DISTRIBUTIONS] = {"independent", "correlated", "anti-correlated", "clustered",
+                                                          "duplicate"};
+
+// A piecewise constant arrival rate: RATE[:COUNT],... where each rate holds
+// for COUNT tuples and the last one for the rest of the stream.
+class schedule {
+public:
+  auto parse(const char *text) -> bool {
+    char *p = (char *) text;
+    while (*p) {
+      segment s;
+      s.rate = strtod(p, &p);
+      if (s.rate <= 0) {
+        return false;
+      }
+      if (*p == ':') {
+        s.count = strtoul(p + 1, &p, 10);
+      }
+      segments_.push_back(s);
+      if (*p == ',') {
+        ++p;
+      } else if (*p) {
+        return false;
+      }
+    }
+    return !segments_.empty();
+  }
+  auto empty() const -> bool {
+    return segments_.empty();
+  }
+  // The rate for the n-th tuple.
+  auto rate(size_t n) const -> double {
+    for (auto &&s : segments_) {
+      if (!s.count || n < s.count) {
+        return s.rate;
+      }
+      n -= s.count;
+    }
+    return segments_.back().rate;
+  }
+private:
+  struct segment {
+    double rate = 0;
+    size_t count = 0;
+  };
+  std::vector<segment> segments_;
+};
+
+auto usage() -> int {
+  std::cout << "Usage: generate [-b] [-k K] [-r SCHEDULE] [-s SEED] DISTRIBUTION DIMENSIONALITY LENGTH OUTPUT"
+            << std::endl;
+  std::cout << "  DISTRIBUTION  independent, correlated, anti-correlated, clustered or duplicate" << std::endl;
+  std::cout << "  -b            Write a binary stream instead of CSV" << std::endl;
+  std::cout << "  -k K          Clusters, or distinct values per dimension of duplicate (default 10)" << std::endl;
+  std::cout << "  -r SCHEDULE   Prefix tuples with Poisson arrival timestamps in seconds, at rates" << std::endl;
+  std::cout << "                RATE[:COUNT],... tuples per second, each for COUNT tuples" << std::endl;
+  std::cout << "  -s SEED       Random seed (default 1)" << std::endl;
+  return 0;
+}
+
+auto main(int argc, char **argv) -> int {
+  bool binary = false;
+  size_t k = 10;
+  uint64_t seed = 1;
+  schedule arrivals;
+  int c;
+  while ((c = getopt(argc, argv, "bk:r:s:")) != -1) {
+    switch (c) {
+      case 'b':
+        binary = true;
+        break;
+      case 'k':
+        k = strtoul(optarg, nullptr, 10);
+        break;
+      case 'r':
+        if (!arrivals.parse(optarg)) {
+          std::cerr << "Invalid schedule " << optarg << std::endl;
+          return 1;
+        }
+        break;
+      case 's':
+        seed = strtoull(optarg, nullptr, 10);
+        break;
+      default:
+        return usage();
+    }
+  }
+  if (argc - optind < 4) {
+    return usage();
+  }
+  generator::distribution d;
+  if (!generator::find(argv[optind], d)) {
+    std::cerr << "Unknown distribution " << argv[optind] << std::endl;
+    return 1;
+  }
+  size_t dimensionality = strtoul(argv[optind + 1], nullptr, 10);
+  size_t length = strtoul(argv[optind + 2], nullptr, 10);
+  const char *target = argv[optind + 3];
+  if (dimensionality == 0 || k == 0) {
+    std::cerr << "Invalid dimensionality or K" << std::endl;
+    return 1;
+  }
+  generator g(d, dimensionality, k, seed);
+  bool timed = !arrivals.empty();
+  size_t stride = dimensionality + (timed ? 1 : 0);
+  std::vector<value_t> row(stride, 0);
+  double stamp = 0;
+  if (binary) {
+    std::ofstream out(target, std::ios::binary | std::ios::trunc);
+    if (!out.good()) {
+      std::cerr << "Cannot create stream " << target << std::endl;
+      return 1;
+    }
+    binary_header header;
+    header.width = (uint32_t) dimensionality;
+    header.flags = timed ? binary_header::TIMESTAMP : 0;
+    header.count = length;
+    out.write((const char *) &header, sizeof(header));
+    for (size_t n = 0; n < length; ++n) {
+      if (timed) {
+        stamp += g.arrival(arrivals.rate(n));
+        row[0] = stamp;
+      }
+      g.next(&row[stride - dimensionality]);
+      out.write((const char *) row.data(), sizeof(value_t) * stride);
+    }
+    out.close();
+    if (!out.good()) {
+      std::cerr << "Cannot write stream " << target << std::endl;
+      return 1;
+    }
+  } else {
+    FILE *out = fopen(target, "w");
+    if (!out) {
+      std::cerr << "Cannot create stream " << target << std::endl;
+      return 1;
+    }
+    for (size_t n = 0; n < length; ++n) {
+      if (timed) {
+        stamp += g.arrival(arrivals.rate(n));
+        row[0] = stamp;
+      }
+      g.next(&row[stride - dimensionality]);
+      for (size_t i = 0; i < stride; ++i) {
+        fprintf(out, i ? ", %.6f" : "%.6f", row[i]);
+      }
+      fputc('\n', out);
+    }
+    if (fclose(out)) {
+      std::cerr << "Cannot write stream " << target << std::endl;
+      return 1;
+    }
+  }
+  std::cerr << length << " tuples written" << std::endl;
+  return 0;
+}
@@ -37,8 +37,17 @@
 #define POST_WINDOW_COUNT 2000
 #endif
 
+#include <algorithm>
+#include <sstream>
 #include <unordered_set>
+#include <utility>
+#include <vector>
+#include "sdis-block.h"
 #include "sdis-cache.h"
+#include "sdis-latency.h"
+#include "sdis-profile.h"
+#include "sdis-recent.h"
+#include "sdis-sink.h"
 #include "sdis-skyline.h"
 #include "sdis-stream.h"
 #include "timer.h"
@@ -48,38 +57,40 @@ namespace sdistream {
 
 static skyline skyline;
 
-template<class IN>
-void skyline_update(IN &in, size_t width, size_t window) {
+// Specialized on the dimensionality D, or generic for D = 0.
+template<class IN, size_t D = 0>
+void skyline_update(IN &in, size_t dimensionality, size_t window, sink &out) {
+  const size_t width = D ? D : dimensionality; // Constant in the specialized engines.
   cache cache(width, window); // Tuple cache.
   size_t count = 0;
   std::unordered_set<index_t> deal;
+  typedef std::pair<value_t, index_t> scored; // A tuple to promote with its score.
+  std::vector<scored> promotions;
   bool display = false;
-  auto entries = new cache_entry[width]; // Index entry buffer.
-  auto entries_remove = new cache_entry[width]; // Index entry buffer of the tuple to remove.
   auto entries_update =
       new cache_entry[width]; // Index entry buffer of the non-skyline tuple to update while removing a tuple.
   index_t index = 0; // Index ID of the incoming tuple.
-  auto indexes = new std::set<cache_entry>[width]; // Dimensional indexes.
-  std::set<index_t> remove;
+  auto candidates = new btree<cache_entry>[width]; // Dimensional indexes of the skyline tuples.
+  block points(width); // Skyline tuples stored column-wise.
   index_t start = 0;
-  auto tuple = new value_t[width]; // Tuple input buffer.
+  row<D> buffer(width); // Tuple input buffer.
+  auto tuple = buffer.data();
   timer t; // Timer for performance evaluation.
+  latency lat; // Per-tuple latencies once the window is filled.
+  profile prof(skyline::DT); // Per-phase costs.
+  recent<index_t> dominators(width, skyline::DT); // Skyline tuples that recently dominated incoming tuples.
   // Add the first tuple.
   if (!input(in, width, tuple)) {
-    delete[] tuple;
     return;
   }
   t.start();
   index = cache.put(tuple, true);
-  for (size_t i = 0; i < width; ++i) {
-    entries[i].index = index;
-    entries[i].value = tuple[i];
-    indexes[i].insert(entries[i]);
-  }
   skyline.add(index);
+  insert_dimensions(candidates, index, tuple, width);
+  points.add(index, tuple);
   start = index;
   t.stop();
-  std::cout << "# " << index << " + " << t.runtime() << " " << skyline.size() << " " << count << std::endl;
+  out.put(true, index, false, t.runtime(), {skyline.size(), count});
   // Process incoming tuples.
   while (input(in, width, tuple)) {
     if (count >= POST_WINDOW_COUNT) {
@@ -92,174 +103,134 @@ void skyline_update(IN &in, size_t width, size_t window) {
       display = true;
       t.reset();
     }
-    for (size_t i = 0; i < width; ++i) {
-      entries[i].index = index;
-      entries[i].value = tuple[i];
-    }
     // Remove expired tuples.
+    prof.enter(profile::EXPIRY);
+    bool expiry = false;
     auto &&expired = cache.expired();
     if (!expired.empty()) {
-      remove.clear();
-      for (auto &&x : expired) {
-        remove.insert(x);
-      }
-      for (auto &&index_remove : remove) {
-        // Build index entry of the tuple to remove.
+      // Remove all expired tuples first, gathering the unexpired tuples that
+      // the expired skyline tuples dominate.
+      auto &&last = expired.back();
+      skyline.expire(last);
+      deal.clear();
+      promotions.clear();
+      for (auto &&index_remove : expired) {
         auto &&tuple_remove = cache.get(index_remove);
         // If tuple does not exist (should not happen), continue with the next one.
         if (!tuple_remove) {
           continue;
         }
-        // Remove expired tuple from all dimensional indexes.
-        for (size_t i = 0; i < width; ++i) {
-          entries_remove[i].index = index_remove;
-          entries_remove[i].value = tuple_remove[i];
-          indexes[i].erase(entries_remove[i]);
-        }
         // The expired tuple is a skyline tuple.
-        // Can it be optimized ???????
         if (skyline.contains(index_remove)) {
-          deal.clear();
+          expiry = true;
           for (auto &&index_update : skyline.get(index_remove)) {
-            // Ignore tuples that have already been removed.
-            if (!cache.contains(index_update) || index_update < index_remove) {
-              continue;
-            }
-            deal.insert(index_update);
-            auto &&tuple_update = cache.get(index_update); // Green warm.
-            for (size_t i = 0; i < width; ++i) {
-              entries_update[i].index = index_update;
-              entries_update[i].value = tuple_update[i];
-            }
-            auto &&lower_bound_dimension = lower_dimension(entries_update, indexes, width);
-            auto &&lower_bound_entry = entries_update[lower_bound_dimension];
-            auto &&lower_bound_index = indexes[lower_bound_dimension];
-            auto &&lower = lower_bound_index.begin();
-            bool dominated = false;
-            while (lower->value <= lower_bound_entry.value && lower != lower_bound_index.end()) {
-              // If the lower tuple is not in skyline set or is the expired tuple,
-              // ignore it.
-              if (!skyline.contains(lower->index) || lower->index == index_remove) {
-                ++lower;
-                continue;
-              }
-              // If current tuple is dominated ALSO by the lower tuple, do break.
-              if (dominate<value_t>(cache.get(lower->index), tuple_update, width)) {
-                skyline.append(lower->index, index_update);
-                dominated = true;
-                break;
-              }
-              // If current tuple is not dominated by the lower tuple, even the
-              // lower tuple has the same value as the current tuple, the reverse
-              // dominance checking is not necessary. Just comment the following
-              // code.
-              //if (lower->value == lower_bound_entry.value && dominate<value_t>(tuple, cache.get(lower->index), width)) {
-              //  skyline.move(lower->index, index);
-              //}
-              ++lower;
-            }
-            if (!dominated) {
-              skyline.add(index_update);
-            }
-            // Dominance tree entries do not respect dimensional indexing order,
-            // a local BNL must be applied to fix this problem.
-            for (auto &&x : deal) {
-              if (x != index_update && skyline.contains(x) > 0) {
-                if (dominate<value_t>(tuple_update, cache.get(x), width)) {
-                  skyline.move(x, index_update);
-                }
-              }
+            // Ignore tuples expiring in the same batch.
+            if (index_update > last && deal.insert(index_update).second) {
+              promotions.emplace_back(dominance::score(cache.get(index_update), width), index_update);
             }
           }
+          erase_dimensions(candidates, index_remove, tuple_remove, width);
           skyline.remove(index_remove);
+          points.remove(index_remove);
+          dominators.erase(index_remove);
         }
       }
-      cache.clean();
-    }
-    // Do lower-bound dominance checking.
-    bool dominated = false;
-    auto &&lower_bound_dimension = lower_dimension(entries, indexes, width);
-    auto &&lower_bound_entry = entries[lower_bound_dimension];
-    auto &&lower_bound_index = indexes[lower_bound_dimension];
-    auto &&lower = lower_bound_index.begin();
-    while (lower->index < index && lower->value <= lower_bound_entry.value && lower != lower_bound_index.end()) {
-      // Only compare the incoming tuple with skyline tuples.
-      if (!skyline.contains(lower->index)) {
-        ++lower;
-        continue;
-      }
-      // If the incoming tuple is dominated by a lower skyline tuple, do break.
-      // The skyline flag of the incoming tuple will be set while adding it
-      // to the cache.
-      if (dominate<value_t>(cache.get(lower->index), tuple, width)) {
-        dominated = true;
-        skyline.append(lower->index, index);
-        break;
-      }
-      // If the incoming tuple is not dominated by the lower tuple, however the
-      // lower tuple has the same value as the current tuple, then do reverse
-      // dominance checking.
-      if (lower->value == lower_bound_entry.value && dominate<value_t>(tuple, cache.get(lower->index), width)) {
-        skyline.move(lower->index, index);
-      }
-      ++lower;
-    }
-    // Do upper-bound dominance checking.
-    if (!dominated) {
-      skyline.add(index);
-      auto &&upper_bound_dimension = upper_dimension(entries, indexes, width);
-      auto &&upper_bound_entry = entries[upper_bound_dimension];
-      auto &&upper_bound_index = indexes[upper_bound_dimension];
-      auto &&upper_repeat = std::set<cache_entry>::reverse_iterator(upper_bound_index.lower_bound(upper_bound_entry));
-      // For repeating dimensional values.
-      while (upper_repeat->index < index && upper_repeat != upper_bound_index.rend()) {
-        if (!skyline.contains(upper_repeat->index)) {
-          ++upper_repeat;
-          continue;
+      // Sort-filter the gathered tuples against the surviving skyline: in
+      // score order, no tuple is dominated by a later one, so accepted tuples
+      // are final.
+      std::sort(promotions.begin(), promotions.end(), [&](const scored &p1, const scored &p2) {
+        return dominance::precede(cache.get(p1.second), p1.first, cache.get(p2.second), p2.first, width);
+      });
+      for (auto &&promotion : promotions) {
+        auto &&index_update = promotion.second;
+        auto &&tuple_update = cache.get(index_update); // Green warm.
+        for (size_t i = 0; i < width; ++i) {
+          entries_update[i].index = index_update;
+          entries_update[i].value = tuple_update[i];
         }
-        if (upper_repeat->value < upper_bound_entry.value) {
-          break;
+        auto &&lower_bound_dimension = lower_dimension(entries_update, candidates, width);
+        auto &&lower_bound_entry = entries_update[lower_bound_dimension];
+        auto &&lower_bound_index = candidates[lower_bound_dimension];
+        auto &&lower = lower_bound_index.begin();
+        bool dominated = false;
+        while (lower != lower_bound_index.end() && lower->value <= lower_bound_entry.value) {
+          prof.visit();
+          // If current tuple is dominated ALSO by the lower tuple, do break.
+          if (dominate<value_t>(cache.get(lower->index), tuple_update, width)) {
+            skyline.append(lower->index, index_update);
+            dominated = true;
+            break;
+          }
+          ++lower;
         }
-        // A tuple with repeat dimensional value is dominated by the incoming
-        // tuple.
-        if (dominate<value_t>(tuple, cache.get(upper_repeat->index), width)) {
-          skyline.move(upper_repeat->index, index);
+        if (!dominated) {
+          skyline.add(index_update);
+          insert_dimensions(candidates, index_update, tuple_update, width);
+          points.add(index_update, tuple_update);
         }
-        ++upper_repeat;
       }
-      // Find all upper skyline tuples that are dominated by the
-      // incoming tuple.
-      auto &&upper = upper_bound_index.upper_bound(upper_bound_entry);
-      while (upper != upper_bound_index.end()) {
-        if (!skyline.contains(upper->index)) {
-          ++upper;
-          continue;
-        }
-        if (dominate<value_t>(tuple, cache.get(upper->index), width)) {
-          skyline.move(upper->index, index);
-        }
-        ++upper;
+      cache.clean();
+    }
+    // Test the incoming tuple against the recent dominators, then against all
+    // skyline tuples at once.
+    prof.enter(profile::LOWER);
+    index_t dominating;
+    bool dominated = dominators.probe(tuple, dominating);
+    if (!dominated) {
+      dominated = points.test(tuple, dominating);
+      if (dominated) {
+        dominators.put(dominating, cache.get(dominating));
       }
     }
-    // Add the incoming tuple to all dimensional indexes.
-    for (size_t i = 0; i < width; ++i) {
-      indexes[i].insert(entries[i]);
+    if (dominated) {
+      skyline.append(dominating, index);
+    } else {
+      // Move the skyline tuples dominated by the incoming tuple.
+      prof.enter(profile::UPPER);
+      skyline.add(index);
+      for (auto &&x : points.dominated()) {
+        skyline.move(x, index);
+        erase_dimensions(candidates, x, cache.get(x), width);
+        points.remove(x);
+        dominators.erase(x);
+      }
+      insert_dimensions(candidates, index, tuple, width);
+      points.add(index, tuple);
     }
     t.stop();
     if (display) {
       ++count;
-      std::cout << index << (dominated ? " - " : " + ") << t.runtime() << " " << skyline.size() << " " << cache.size()
-                << " " << count << std::endl;
+      auto &&reported = out.put(false, index, dominated, t.runtime(), {skyline.size(), cache.size(), count});
+      prof.next(out, reported);
+      auto &&kind = expiry ? latency::EXPIRY : dominated ? latency::DOMINATED : latency::INSERT;
+      if (lat.put(kind, t.elapsed())) {
+        lat.report(out);
+      }
     } else {
-      std::cout << "# " << index << " + " << t.runtime() << " " << skyline.size() << " " << count << std::endl;
+      auto &&reported = out.put(true, index, false, t.runtime(), {skyline.size(), count});
+      prof.next(out, reported);
     }
   }
-  delete[] entries;
-  delete[] entries_remove;
   delete[] entries_update;
-  delete[] indexes;
-  delete[] tuple;
-  std::cout << "# Mean processing time: " << (count ? t.total() / count : 0) << " sec/tuple" << std::endl;
+  delete[] candidates;
+  prof.report(out);
+  lat.report(out);
+  std::ostringstream summary;
+  summary << "# Mean processing time: " << (count ? t.total() / count : 0) << " sec/tuple";
+  out.comment(summary.str());
+  std::ostringstream totals;
+  totals << "# Dominance tests: " << skyline::DT << ", skyline size: " << skyline.size();
+  out.comment(totals.str());
+  std::ostringstream tails;
+  tails << "# Tail entries: " << skyline.tail_live() << " live of " << skyline.tail_total();
+  out.comment(tails.str());
+  std::ostringstream hits;
+  hits << "# Recent dominators: " << dominators.hits() << " hits of " << dominators.probes() << " probes";
+  out.comment(hits.str());
+  std::ostringstream rows;
+  rows << "# Cache peak: " << cache.peak() / 1024 << " KiB";
+  out.comment(rows.str());
+  out.flush();
 }
 
 }
@@ -26,41 +26,177 @@
  * $Id: log.h 998 2014-12-18 12:07:14Z li $
  */
 
+#include <sys/resource.h>
+#include <unistd.h>
 #include <fstream>
 #include <iostream>
+#include <sstream>
 #include "rssi-time.h"
+#include "sdis-latency.h"
+#include "sdis-mmap.h"
+#include "sdis-pipeline.h"
+#include "sdis-profile.h"
+#include "sdis-sink.h"
 #include "timer.h"
 using namespace sdistream;
 
-auto run_skyline(const char *name, size_t dimensionality, size_t window, const char *stream) -> bool {
+// Run the engine specialized on the dimensionality, or the generic one.
+template<class IN>
+void run_engine(IN &in, size_t dimensionality, size_t window, sink &out) {
+  switch (dimensionality) {
+    case 2:
+      return skyline_update<IN, 2>(in, dimensionality, window, out);
+    case 3:
+      return skyline_update<IN, 3>(in, dimensionality, window, out);
+    case 4:
+      return skyline_update<IN, 4>(in, dimensionality, window, out);
+    case 5:
+      return skyline_update<IN, 5>(in, dimensionality, window, out);
+    case 6:
+      return skyline_update<IN, 6>(in, dimensionality, window, out);
+    case 7:
+      return skyline_update<IN, 7>(in, dimensionality, window, out);
+    case 8:
+      return skyline_update<IN, 8>(in, dimensionality, window, out);
+    case 9:
+      return skyline_update<IN, 9>(in, dimensionality, window, out);
+    case 10:
+      return skyline_update<IN, 10>(in, dimensionality, window, out);
+    case 11:
+      return skyline_update<IN, 11>(in, dimensionality, window, out);
+    case 12:
+      return skyline_update<IN, 12>(in, dimensionality, window, out);
+    case 13:
+      return skyline_update<IN, 13>(in, dimensionality, window, out);
+    case 14:
+      return skyline_update<IN, 14>(in, dimensionality, window, out);
+    case 15:
+      return skyline_update<IN, 15>(in, dimensionality, window, out);
+    case 16:
+      return skyline_update<IN, 16>(in, dimensionality, window, out);
+    default:
+      return skyline_update<IN>(in, dimensionality, window, out);
+  }
+}
+
+template<class IN>
+void run_stream(IN &in, size_t dimensionality, size_t window, size_t depth, sink &out) {
   timer t;
+  if (depth) {
+    // Parse the stream in a reader thread.
+    pipeline pipe(dimensionality, depth);
+    pipe.start(in);
+    t.start();
+    run_engine<pipeline>(pipe, dimensionality, window, out);
+    t.stop();
+    pipe.stop();
+    std::ostringstream summary;
+    summary << "# Pipeline: " << pipe.blocks() << " blocks, " << pipe.producer_stalls() << " reader stalls, "
+            << pipe.consumer_stalls() << " engine stalls";
+    out.comment(summary.str());
+  } else {
+    t.start();
+    run_engine<IN>(in, dimensionality, window, out);
+    t.stop();
+  }
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+    std::ostringstream summary;
+    summary << "# Peak RSS: " << usage.ru_maxrss << " KiB";
+    out.comment(summary.str());
+  }
+  out.flush();
+}
+
+auto run_skyline(const char *name, size_t dimensionality, size_t window, const char *stream, size_t depth,
+                 sink &out) -> bool {
   std::cerr << "Running..." << std::endl;
   if (stream) {
+    // Read binary streams and parse regular files in place, fall back to
+    // std::ifstream otherwise.
+    binary_stream bin;
+    if (bin.open(stream)) {
+      if (bin.width() < dimensionality) {
+        std::cerr << "Stream " << stream << " has only " << bin.width() << " dimensions" << std::endl;
+        return false;
+      }
+      bin.pace(true); // Replay recorded timestamps for time windows.
+      run_stream(bin, dimensionality, window, depth, out);
+      return true;
+    }
+    csv_stream csv;
+    if (csv.open(stream)) {
+      run_stream(csv, dimensionality, window, depth, out);
+      return true;
+    }
     std::ifstream in(stream);
     if (!in.good()) {
       std::cerr << "Cannot open stream " << stream << std::endl;
       return false;
     }
-    t.start();
-    skyline_update<std::ifstream>(in, dimensionality, window);
-    t.stop();
-    in.close();
+    run_stream<std::istream>(in, dimensionality, window, depth, out);
   } else {
-    t.start();
-    skyline_update<std::istream>(std::cin, dimensionality, window);
-    t.stop();
+    run_stream<std::istream>(std::cin, dimensionality, window, depth, out);
   }
   return true;
 }
 
+auto usage() -> int {
+  std::cout << "Usage: rssi-time [-p DEPTH] [-s SINK] [-o FILE] [-r INTERVAL] [-l PERIOD] [-P]" << std::endl;
+  std::cout << "       DIMENSIONALITY WINDOW [STREAM]" << std::endl;
+  std::cout << "  -p DEPTH     Parse the stream in a reader thread through a ring of DEPTH blocks" << std::endl;
+  std::cout << "  -s SINK      Write results as text (default), binary or null" << std::endl;
+  std::cout << "  -o FILE      Write results to FILE instead of the standard output" << std::endl;
+  std::cout << "  -r INTERVAL  Report every INTERVAL tuples, 0 for the summary only (default 1)" << std::endl;
+  std::cout << "  -l PERIOD    Report latency percentiles every PERIOD tuples, 0 at the end only (default 0)"
+            << std::endl;
+  std::cout << "  -P           Break the processing cost down by update phase" << std::endl;
+  return 0;
+}
+
 auto main(int argc, char **argv) -> int {
-  if (argc < 3) {
-    std::cout << "Usage: rssi-time DIMENSIONALITY WINDOW [STREAM]" << std::endl;
-    return 0;
+  size_t depth = 0;
+  size_t interval = 1;
+  const char *kind = nullptr;
+  const char *path = nullptr;
+  int c;
+  while ((c = getopt(argc, argv, "l:o:p:r:s:P")) != -1) {
+    switch (c) {
+      case 'l':
+        latency::period = strtoul(optarg, nullptr, 10);
+        break;
+      case 'o':
+        path = optarg;
+        break;
+      case 'p':
+        depth = strtoul(optarg, nullptr, 10);
+        break;
+      case 'r':
+        interval = strtoul(optarg, nullptr, 10);
+        break;
+      case 's':
+        kind = optarg;
+        break;
+      case 'P':
+        profile::enabled = true;
+        break;
+      default:
+        return usage();
+    }
+  }
+  if (argc - optind < 2) {
+    return usage();
+  }
+  size_t dimensionality = strtoul(argv[optind], nullptr, 10);
+  size_t window = strtoul(argv[optind + 1], nullptr, 10);
+  const char *stream = argc - optind > 2 ? argv[optind + 2] : nullptr;
+  sink *out = sink::create(kind, path, interval);
+  if (!out) {
+    std::cerr << "Cannot create " << (kind ? kind : "text") << " sink" << (path ? " " : "") << (path ? path : "")
+              << std::endl;
+    return 1;
   }
-  size_t dimensionality = strtoul(argv[1], nullptr, 10);
-  size_t window = strtoul(argv[2], nullptr, 10);
-  const char *stream = argc > 3 ? argv[3] : nullptr;
-  run_skyline("RSSi-TIME", dimensionality, window, stream);
+  run_skyline("RSSi-TIME", dimensionality, window, stream, depth, *out);
+  delete out;
   return 0;
 }
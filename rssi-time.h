@@ -37,8 +37,17 @@
 #define POST_WINDOW_COUNT 2000
 #endif
 
+#include <algorithm>
+#include <sstream>
 #include <unordered_set>
+#include <utility>
+#include <vector>
+#include "sdis-dominance.h"
 #include "sdis-index.h"
+#include "sdis-latency.h"
+#include "sdis-profile.h"
+#include "sdis-recent.h"
+#include "sdis-sink.h"
 #include "sdis-stream.h"
 #include "timer.h"
 #include "types.h"
@@ -47,20 +56,27 @@ namespace sdistream {
 
 static std::unordered_set<index::header *> skyline;
 
-template<class IN>
-void skyline_update(IN &in, size_t width, size_t window) {
-  auto buffer = new value_t[width]; // Tuple input buffer.
+// Specialized on the dimensionality D, or generic for D = 0.
+template<class IN, size_t D = 0>
+void skyline_update(IN &in, size_t dimensionality, size_t window, sink &out) {
+  const size_t width = D ? D : dimensionality; // Constant in the specialized engines.
+  row<D> tuple(width); // Tuple input buffer.
+  auto buffer = tuple.data();
   size_t count = 0;
   std::unordered_set<index::header *> deal;
+  typedef std::pair<value_t, index::header *> scored; // A tuple to promote with its score.
+  std::vector<scored> promotions;
   index::header *header; // Current tuple herder.
   class index index(buffer, width, window); // Dimensional indexes.
-  std::unordered_set<index::header *> removes;
   stamp_t stamp; // Current tuple stamp.
   stamp_t start; // Starting tuple stamp.
   timer t; // Timer for performance evaluation.
+  latency lat; // Per-tuple latencies once the window is filled.
+  profile prof(index::DT); // Per-phase costs.
+  recent<index::header *> dominators(width, index::DT); // Skyline tuples that recently dominated incoming tuples.
+  size_t filled = 0; // Index allocations once the window is filled.
   // Process the first incoming tuple.
   if (!input(in, width, buffer)) {
-    delete[] buffer;
     return;
   }
   t.start();
@@ -68,8 +84,7 @@ void skyline_update(IN &in, size_t width, size_t window) {
   skyline.insert(header);
   start = header->stamp;
   t.stop();
-  std::cout << "# " << header->stamp << " + " << t.runtime() << " " << skyline.size() << " " << index.size() << " "
-            << index.expired().size() << " " << count << std::endl;
+  out.put(true, header->stamp, false, t.runtime(), {skyline.size(), index.size(), index.expired().size(), count});
   // Process incoming tuples.
   while (input(in, width, buffer)) {
     if (count >= POST_WINDOW_COUNT) {
@@ -79,115 +94,122 @@ void skyline_update(IN &in, size_t width, size_t window) {
     t.start();
     // Get the next stamp.
     stamp = index.next();
+    prof.enter(profile::EXPIRY);
+    bool expiry = false;
     // Remove the expired tuples.
     auto &&expired = index.expired();
     if (!expired.empty()) {
-      removes.clear();
-      for (auto &&x : expired) {
-        removes.insert(x);
-      }
-      // Build index entry of the tuple to remove.
-      for (auto &&remove : removes) {
+      // Remove all expired tuples first, gathering the unexpired tuples that
+      // the expired skyline tuples dominate.
+      auto last = expired.back().stamp;
+      deal.clear();
+      promotions.clear();
+      for (auto &&h : expired) {
+        auto remove = &h;
         ///std::cout << remove->stamp << (remove->skyline ? " + " : " - ") << " " << remove->tail.size() << std::endl;
         // The expired tuple is a skyline tuple.
         if (remove->skyline) {
-          deal.clear();
-          for (auto &&update : index.tail_get(remove, remove->stamp)) {
-            deal.insert(update);
-            auto &&update_tuple = update->tuple;
-            auto &&lower_dimension = index.lower(update);
-            auto &&lower_index = index.get(lower_dimension);
-            auto &&lower_iterator = lower_index.begin();
-            bool dominated = false;
-            while (lower_iterator != lower_index.end()
-                && lower_iterator->header->value(lower_dimension) < update->value(lower_dimension)) {
-              auto &&lower = lower_iterator->header;
-              auto &&lower_tuple = lower->tuple;
-              // If the lower tuple is not in skyline set or is the expired tuple,
-              // ignore it.
-              if (!lower->skyline || lower->stamp == remove->stamp) {
-                ++lower_iterator;
-                continue;
-              }
-              // If current tuple is dominated ALSO by the lower tuple, do break.
-              if (dominate(lower_tuple, update_tuple)) {
-                index.tail_append(lower, update);
-                dominated = true;
-                break;
-              }
-              ++lower_iterator;
-            }
-            if (!dominated) {
-              update->skyline = true;
-              skyline.insert(update);
-            }
-            // Dominance tree entries do not respect dimensional indexing order,
-            // a local BNL must be applied to fix this problem.
-            for (auto &&x : deal) {
-              if (x != update && x->skyline) {
-                if (dominate(update_tuple, x->tuple)) {
-                  x->skyline = false;
-                  index.tail_move(x, update);
-                  skyline.erase(x);
-                }
-              }
+          expiry = true;
+          index.demote(remove);
+          dominators.erase(remove);
+          for (auto &&update : index.tail_get(remove, last)) {
+            if (deal.insert(update).second) {
+              promotions.emplace_back(dominance::score(update->tuple, width), update);
             }
           }
           skyline.erase(remove);
         }
       }
+      prof.enter(profile::INDEX);
       index.pop();
+      // Sort-filter the gathered tuples against the surviving skyline: in
+      // score order, no tuple is dominated by a later one, so accepted tuples
+      // are final.
+      prof.enter(profile::EXPIRY);
+      std::sort(promotions.begin(), promotions.end(), [&](const scored &p1, const scored &p2) {
+        return dominance::precede(p1.second->tuple, p1.first, p2.second->tuple, p2.first, width);
+      });
+      for (auto &&promotion : promotions) {
+        auto &&update = promotion.second;
+        auto &&lower_dimension = index.lower(update);
+        auto &&lower_index = index.candidates(lower_dimension);
+        auto &&lower_iterator = lower_index.begin();
+        bool dominated = false;
+        while (lower_iterator != lower_index.end() && lower_iterator->value <= update->value(lower_dimension)) {
+          auto &&lower = lower_iterator->header;
+          prof.visit();
+          // If current tuple is dominated ALSO by the lower tuple, do break.
+          if (index.dominate(lower, update)) {
+            index.tail_append(lower, update);
+            dominated = true;
+            break;
+          }
+          ++lower_iterator;
+        }
+        if (!dominated) {
+          index.promote(update);
+          skyline.insert(update);
+        }
+      }
     }
     // Put buffered incoming tuple to index.
     header = index.put();
     // Do lower-bound dominance checking.
-    bool dominated = false;
-    auto &&lower_dimension = index.lower();
-    auto &&lower_index = index.get(lower_dimension);
-    auto &&lower_iterator = lower_index.begin();
-    while (lower_iterator != lower_index.end() && lower_iterator->value <= buffer[lower_dimension]) {
-      auto &&lower = lower_iterator->header;
-      auto &&lower_tuple = lower->tuple;
-      // Only compare the incoming tuple with skyline tuples.
-      if (!lower->skyline) {
+    prof.enter(profile::LOWER);
+    index::header *dominating;
+    bool dominated = dominators.probe(buffer, dominating);
+    if (dominated) {
+      // A recent dominator of the incoming tuple saves the lower-bound scan.
+      index.tail_append(dominating, header);
+    } else {
+      auto &&lower_dimension = index.lower();
+      auto &&lower_index = index.candidates(lower_dimension);
+      auto &&lower_iterator = lower_index.begin();
+      while (lower_iterator != lower_index.end() && lower_iterator->value <= buffer[lower_dimension]) {
+        auto &&lower = lower_iterator->header;
+        prof.visit();
+        // Skip the skyline tuples demoted during this scan.
+        if (!lower->skyline) {
+          prof.skip();
+          ++lower_iterator;
+          continue;
+        }
+        // If the incoming tuple is dominated by a lower skyline tuple, do break.
+        // The skyline flag of the incoming tuple will be set while adding it
+        // to the cache.
+        if (index.dominate(lower, buffer)) {
+          dominated = true;
+          index.tail_append(lower, header);
+          dominators.put(lower, lower->tuple);
+          break;
+        }
+        // If the incoming tuple is not dominated by the lower tuple, however the
+        // lower tuple has the same value as the current tuple, then do reverse
+        // dominance checking.
+        if (lower_iterator->value == buffer[lower_dimension] && index.dominate(buffer, lower)) {
+          index.demote(lower);
+          dominators.erase(lower);
+          index.tail_move(lower, header);
+          skyline.insert(header);
+          skyline.erase(lower);
+        }
         ++lower_iterator;
-        continue;
-      }
-      // If the incoming tuple is dominated by a lower skyline tuple, do break.
-      // The skyline flag of the incoming tuple will be set while adding it
-      // to the cache.
-      if (dominate(lower_tuple, buffer)) {
-        dominated = true;
-        index.tail_append(lower, header);
-        break;
       }
-      // If the incoming tuple is not dominated by the lower tuple, however the
-      // lower tuple has the same value as the current tuple, then do reverse
-      // dominance checking.
-      if (lower_iterator->value == buffer[lower_dimension] && dominate(buffer, lower_tuple)) {
-        lower->skyline = false;
-        index.tail_move(lower, header);
-        skyline.insert(header);
-        skyline.erase(lower);
-      }
-      ++lower_iterator;
     }
     // Do upper-bound dominance checking.
     if (!dominated) {
       skyline.insert(header);
-      header->skyline = true;
+      prof.enter(profile::REPEAT);
       auto &&upper_dimension = index.upper();
-      auto &&upper_index = index.get(upper_dimension);
+      auto &&upper_index = index.candidates(upper_dimension);
       auto &&upper_entry = index.mute(buffer[upper_dimension]);
-      auto &&upper_repeat_iterator = std::set<index::entry>::reverse_iterator(upper_index.lower_bound(upper_entry));
+      auto &&upper_repeat_iterator = index::reverse_iterator(upper_index.lower_bound(upper_entry));
       // For repeating dimensional values.
       while (upper_repeat_iterator != upper_index.rend()) {
         auto &&upper_repeat = upper_repeat_iterator->header;
-        auto &&upper_repeat_tuple = upper_repeat->tuple;
-        if (!upper_repeat_tuple) {
-          continue;
-        }
-        if (!index::skyline(upper_repeat_tuple)) {
+        prof.visit();
+        if (!upper_repeat->skyline) {
+          prof.skip();
           ++upper_repeat_iterator;
           continue;
         }
@@ -196,8 +218,9 @@ void skyline_update(IN &in, size_t width, size_t window) {
         }
         // A tuple with repeat dimensional value is dominated by the incoming
         // tuple.
-        if (dominate(buffer, upper_repeat_tuple)) {
-          index::skyline(upper_repeat_tuple) = false;
+        if (index.dominate(buffer, upper_repeat)) {
+          index.demote(upper_repeat);
+          dominators.erase(upper_repeat);
           index.tail_move(upper_repeat, header);
           skyline.erase(upper_repeat);
         }
@@ -205,40 +228,63 @@ void skyline_update(IN &in, size_t width, size_t window) {
       }
       // Find all upper skyline tuples that are dominated by the
       // incoming tuple.
+      prof.enter(profile::UPPER);
       auto &&upper_iterator = upper_index.upper_bound(upper_entry);
       while (upper_iterator != upper_index.end()) {
         auto &&upper = upper_iterator->header;
-        auto &&upper_tuple = upper->tuple;
-        if (!upper_tuple) {
-          continue;
-        }
-        if (!skyline.count(upper)) {
+        prof.visit();
+        if (!upper->skyline) {
+          prof.skip();
           ++upper_iterator;
           continue;
         }
-        if (dominate(buffer, upper_tuple)) {
-          upper->skyline = false;
+        if (index.dominate(buffer, upper)) {
+          index.demote(upper);
+          dominators.erase(upper);
           index.tail_move(upper, header);
           skyline.erase(upper);
         }
         ++upper_iterator;
       }
+      prof.enter(profile::INDEX);
+      index.promote(header);
       index.compact();
     } else {
       skyline.erase(header);
     }
     t.stop();
+    if (header->stamp >= window && !count++) {
+      filled = arena::ALLOCATIONS;
+    }
+    auto &&reported = out.put(header->stamp < window, header->stamp, dominated, t.runtime(),
+                              {skyline.size(), index.size(), expired.size(), count});
+    prof.next(out, reported);
     if (header->stamp >= window) {
-      ++count;
-      std::cout << header->stamp << (dominated ? " - " : " + ") << t.runtime() << " " << skyline.size() << " "
-                << index.size() << " " << expired.size() << " " << count << std::endl;
-    } else {
-      std::cout << "# " << header->stamp << (dominated ? " - " : " + ") << t.runtime() << " " << skyline.size() << " "
-                << index.size() << " " << expired.size() << " " << count << std::endl;
+      auto &&kind = expiry ? latency::EXPIRY : dominated ? latency::DOMINATED : latency::INSERT;
+      if (lat.put(kind, t.elapsed())) {
+        lat.report(out);
+      }
     }
   }
-  delete[] buffer;
-  std::cout << "# Mean processing time: " << (count ? t.total() / count : 0) << " sec/tuple" << std::endl;
+  prof.report(out);
+  lat.report(out);
+  std::ostringstream summary;
+  summary << "# Mean processing time: " << (count ? t.total() / count : 0) << " sec/tuple";
+  out.comment(summary.str());
+  std::ostringstream totals;
+  totals << "# Dominance tests: " << index::DT << ", skyline size: " << skyline.size();
+  out.comment(totals.str());
+  std::ostringstream tails;
+  tails << "# Tail entries: " << index.tail_live() << " live of " << index.tail_total();
+  out.comment(tails.str());
+  std::ostringstream hits;
+  hits << "# Recent dominators: " << dominators.hits() << " hits of " << dominators.probes() << " probes";
+  out.comment(hits.str());
+  std::ostringstream allocations;
+  allocations << "# Index allocations: " << arena::ALLOCATIONS << ", "
+              << (count ? arena::ALLOCATIONS - filled : 0) << " once the window is filled";
+  out.comment(allocations.str());
+  out.flush();
 }
 
 }
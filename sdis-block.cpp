@@ -0,0 +1,129 @@
+/*-
+ * Copyright (c) 2019 Rui Liu and Dominique Li <dominique.li@univ-tours.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id: log.h 998 2014-12-18 12:07:14Z li $
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "sdis-block.h"
+#include "sdis-dominance.h"
+#include "sdis-skyline.h"
+
+namespace sdistream {
+
+block::block(size_t width) : width_(width) {
+}
+
+void block::add(const index_t &point, const value_t *tuple) {
+  if (size_ == capacity_) {
+    if (2 * live_ < size_) {
+      compact_();
+    } else {
+      grow_();
+    }
+  }
+  for (size_t i = 0; i < width_; ++i) {
+    columns_[i * capacity_ + size_] = tuple[i];
+  }
+  points_[size_] = point;
+  slots_[point] = size_++;
+  ++live_;
+}
+
+auto block::remove(const index_t &point) -> bool {
+  auto &&s = slots_.find(point);
+  if (s == slots_.end()) {
+    return false;
+  }
+  for (size_t i = 0; i < width_; ++i) {
+    columns_[i * capacity_ + s->second] = NAN;
+  }
+  slots_.erase(s);
+  --live_;
+  return true;
+}
+
+auto block::size() const -> size_t {
+  return live_;
+}
+
+auto block::test(const value_t *tuple, index_t &dominating) -> bool {
+  dominated_.clear();
+  auto &&last = dominance::batch(columns_.data(), capacity_, size_, width_, tuple, mask_.data());
+  // One dominance test per live point scanned, in both directions. Removed
+  // points, filled with NaN, are not counted.
+  if (last < size_) {
+    for (size_t p = last; p < size_; ++p) {
+      skyline::DT += !std::isnan(columns_[p]);
+    }
+    dominating = points_[last];
+    return true;
+  }
+  skyline::DT += live_;
+  for (size_t w = 0; w < (size_ + 63) / 64; ++w) {
+    auto bits = mask_[w];
+    while (bits) {
+      dominated_.push_back(points_[w * 64 + __builtin_ctzll(bits)]);
+      bits &= bits - 1;
+    }
+  }
+  return false;
+}
+
+auto block::dominated() -> const std::vector<index_t> & {
+  return dominated_;
+}
+
+void block::compact_() {
+  size_t size = 0;
+  for (size_t slot = 0; slot < size_; ++slot) {
+    auto &&s = slots_.find(points_[slot]);
+    if (s == slots_.end() || s->second != slot) {
+      continue;
+    }
+    for (size_t i = 0; i < width_; ++i) {
+      columns_[i * capacity_ + size] = columns_[i * capacity_ + slot];
+    }
+    points_[size] = points_[slot];
+    s->second = size++;
+  }
+  size_ = size;
+}
+
+void block::grow_() {
+  auto capacity = capacity_ ? 2 * capacity_ : BLOCK_CAPACITY;
+  std::vector<value_t> columns(width_ * capacity);
+  for (size_t i = 0; i < width_; ++i) {
+    std::copy(columns_.begin() + i * capacity_, columns_.begin() + i * capacity_ + size_,
+              columns.begin() + i * capacity);
+  }
+  columns_.swap(columns);
+  capacity_ = capacity;
+  points_.resize(capacity);
+  mask_.resize(capacity / 64 + 1);
+}
+
+}
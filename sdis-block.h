@@ -0,0 +1,77 @@
+/*-
+ * Copyright (c) 2019 Rui Liu and Dominique Li <dominique.li@univ-tours.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id: log.h 998 2014-12-18 12:07:14Z li $
+ */
+
+#ifndef SDIS_BLOCK_H
+#define SDIS_BLOCK_H
+
+#ifndef BLOCK_CAPACITY
+#define BLOCK_CAPACITY 64
+#endif
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "types.h"
+
+namespace sdistream {
+
+// Skyline points stored column-wise, so that a tuple is tested against all
+// of them in one pass by the batch dominance kernels. Points keep their
+// order of addition: removed points are filled with NaN, which neither
+// dominates nor is dominated, until the block is compacted.
+class block {
+public:
+  explicit block(size_t);
+  // Add a point.
+  void add(const index_t &, const value_t *);
+  // Remove a point.
+  auto remove(const index_t &) -> bool;
+  // The number of points.
+  auto size() const -> size_t;
+  // Test a tuple against all points. Return the latest point dominating
+  // the tuple and true, or false and collect the points the tuple dominates.
+  auto test(const value_t *, index_t &) -> bool;
+  // The points dominated by the last tested tuple.
+  auto dominated() -> const std::vector<index_t> &;
+private:
+  void compact_();
+  void grow_();
+  size_t width_ = 0;
+  size_t size_ = 0; // Points, removed points included.
+  size_t live_ = 0;
+  size_t capacity_ = 0;
+  std::vector<value_t> columns_; // Columns of capacity_ values.
+  std::vector<index_t> points_;
+  std::unordered_map<index_t, size_t> slots_;
+  std::vector<uint64_t> mask_;
+  std::vector<index_t> dominated_;
+};
+
+}
+
+#endif //SDIS_BLOCK_H
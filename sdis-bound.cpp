@@ -26,30 +26,20 @@
  * $Id: log.h 998 2014-12-18 12:07:14Z li $
  */
 
-#include <cmath>
 #include "sdis-bound.h"
 
 namespace sdistream {
 
-auto estimate(const entry &ent, const std::set<entry> &dim) -> double {
+// The share of a dimension ordered before an entry, exact from its rank
+// whatever the distribution of the values.
+auto estimate(const entry &ent, const btree<entry> &dim) -> double {
   if (dim.empty()) {
     return 0;
   }
-  auto &&first = *(dim.begin());
-  auto &&last = *(dim.rbegin());
-  if (first == last) {
-    return 1;
-  }
-  if (ent < first) {
-    return 0;
-  }
-  if (last < ent) {
-    return 1;
-  }
-  return 1.0 * std::abs(ent.value - first.value) / std::abs(last.value - first.value);
+  return 1.0 * dim.rank(ent) / dim.size();
 }
 
-auto lower_dimension(const entry *entries, const std::set<entry> *indexes, size_t width) -> size_t {
+auto lower_dimension(const entry *entries, const btree<entry> *indexes, size_t width) -> size_t {
   size_t d = 0;
   double lower = 1;
   for (size_t i = 0; i < width; ++i) {
@@ -66,7 +56,7 @@ auto lower_dimension(const entry *entries, const std::set<entry> *indexes, size_
   return d;
 }
 
-auto upper_dimension(const entry *entries, const std::set<entry> *indexes, size_t width) -> size_t {
+auto upper_dimension(const entry *entries, const btree<entry> *indexes, size_t width) -> size_t {
   size_t d = 0;
   double upper = 0;
   for (size_t i = 0; i < width; ++i) {
@@ -29,14 +29,14 @@
 #ifndef SDIS_BOUND_H
 #define SDIS_BOUND_H
 
-#include <set>
+#include "sdis-btree.h"
 #include "sdis-entry.h"
 
 namespace sdistream {
 
-auto estimate(const entry &, const std::set<entry> &) -> double;
-auto lower_dimension(const entry *, const std::set<entry> *, size_t) -> size_t;
-auto upper_dimension(const entry *, const std::set<entry> *, size_t) -> size_t;
+auto estimate(const entry &, const btree<entry> &) -> double;
+auto lower_dimension(const entry *, const btree<entry> *, size_t) -> size_t;
+auto upper_dimension(const entry *, const btree<entry> *, size_t) -> size_t;
 
 }
 
@@ -0,0 +1,457 @@
+/*-
+ * Copyright (c) 2019 Rui Liu and Dominique Li <dominique.li@univ-tours.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id: log.h 998 2014-12-18 12:07:14Z li $
+ */
+
+#ifndef SDIS_BTREE_H
+#define SDIS_BTREE_H
+
+#ifndef BTREE_LEAF
+#define BTREE_LEAF 64
+#endif
+
+#ifndef BTREE_FANOUT
+#define BTREE_FANOUT 32
+#endif
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+
+namespace sdistream {
+
+// Ordered set of unique keys in a B+-tree. Leaves hold up to BTREE_LEAF
+// sorted keys contiguously and are linked in key order, so that scans read
+// whole leaves sequentially. Inner nodes hold up to BTREE_FANOUT children
+// and the number of keys below each of them, which ranks a key in
+// logarithmic time. Nodes below a quarter full are merged with or refilled
+// from a sibling. Nodes come from the allocator A rebound to them.
+// Inserting or erasing a key invalidates all iterators.
+template<class T, class A = std::allocator<T>>
+class btree {
+  struct inner;
+  struct node {
+    inner *parent = nullptr;
+    size_t count = 0; // Keys of a leaf, children of an inner node.
+    bool leaf;
+    explicit node(bool l) : leaf(l) {
+    }
+  };
+  // One spare slot, so that nodes split after an insertion.
+  struct leaf_node : node {
+    leaf_node *prev = nullptr;
+    leaf_node *next = nullptr;
+    T keys[BTREE_LEAF + 1];
+    leaf_node() : node(true) {
+    }
+  };
+  // The separator keys[i] is greater than the keys of children[i] and not
+  // greater than the keys of children[i + 1]. The subtree of children[i]
+  // holds sizes[i] keys.
+  struct inner : node {
+    T keys[BTREE_FANOUT];
+    node *children[BTREE_FANOUT + 1];
+    size_t sizes[BTREE_FANOUT + 1];
+    inner() : node(false) {
+    }
+  };
+  static_assert(BTREE_LEAF >= 4 && BTREE_FANOUT >= 8, "B+-tree nodes are too narrow");
+public:
+  class iterator {
+  public:
+    typedef std::bidirectional_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const T *pointer;
+    typedef const T &reference;
+    iterator() = default;
+    auto operator*() const -> reference {
+      return leaf_->keys[pos_];
+    }
+    auto operator->() const -> pointer {
+      return leaf_->keys + pos_;
+    }
+    auto operator++() -> iterator & {
+      if (++pos_ == leaf_->count && leaf_->next) {
+        leaf_ = leaf_->next;
+        pos_ = 0;
+      }
+      return *this;
+    }
+    auto operator++(int) -> iterator {
+      auto it = *this;
+      ++*this;
+      return it;
+    }
+    auto operator--() -> iterator & {
+      if (pos_ == 0) {
+        leaf_ = leaf_->prev;
+        pos_ = leaf_->count;
+      }
+      --pos_;
+      return *this;
+    }
+    auto operator--(int) -> iterator {
+      auto it = *this;
+      --*this;
+      return it;
+    }
+    auto operator==(const iterator &it) const -> bool {
+      return leaf_ == it.leaf_ && pos_ == it.pos_;
+    }
+    auto operator!=(const iterator &it) const -> bool {
+      return !(*this == it);
+    }
+  private:
+    friend class btree;
+    // The end of a leaf is the beginning of the next one, or the end of the
+    // tree for the last leaf.
+    iterator(leaf_node *leaf, size_t pos) : leaf_(leaf), pos_(pos) {
+      if (pos_ == leaf_->count && leaf_->next) {
+        leaf_ = leaf_->next;
+        pos_ = 0;
+      }
+    }
+    leaf_node *leaf_ = nullptr;
+    size_t pos_ = 0;
+  };
+  typedef iterator const_iterator;
+  typedef std::reverse_iterator<iterator> reverse_iterator;
+  typedef std::reverse_iterator<iterator> const_reverse_iterator;
+
+  explicit btree(const A &allocator = A()) : allocator_(allocator) {
+    root_ = first_ = last_ = create_<leaf_node>();
+  }
+  // A moved-from tree may only be destroyed.
+  btree(btree &&tree) noexcept
+      : allocator_(tree.allocator_), root_(tree.root_), first_(tree.first_), last_(tree.last_), size_(tree.size_) {
+    tree.root_ = nullptr;
+  }
+  btree(const btree &) = delete;
+  auto operator=(const btree &) -> btree & = delete;
+  virtual ~btree() {
+    if (root_) {
+      free_(root_);
+    }
+  }
+  auto begin() const -> iterator {
+    return iterator(first_, 0);
+  }
+  auto end() const -> iterator {
+    return iterator(last_, last_->count);
+  }
+  auto rbegin() const -> reverse_iterator {
+    return reverse_iterator(end());
+  }
+  auto rend() const -> reverse_iterator {
+    return reverse_iterator(begin());
+  }
+  auto empty() const -> bool {
+    return size_ == 0;
+  }
+  auto size() const -> size_t {
+    return size_;
+  }
+  // The least key, the tree must not be empty.
+  auto front() const -> const T & {
+    return first_->keys[0];
+  }
+  // The greatest key, the tree must not be empty.
+  auto back() const -> const T & {
+    return last_->keys[last_->count - 1];
+  }
+  // The first key not less than a key.
+  auto lower_bound(const T &key) const -> iterator {
+    auto leaf = find_(key);
+    return iterator(leaf, std::lower_bound(leaf->keys, leaf->keys + leaf->count, key) - leaf->keys);
+  }
+  // The first key greater than a key.
+  auto upper_bound(const T &key) const -> iterator {
+    auto leaf = find_(key);
+    return iterator(leaf, std::upper_bound(leaf->keys, leaf->keys + leaf->count, key) - leaf->keys);
+  }
+  // The number of keys less than a key.
+  auto rank(const T &key) const -> size_t {
+    size_t rank = 0;
+    auto n = root_;
+    while (!n->leaf) {
+      auto in = static_cast<inner *>(n);
+      size_t c = std::upper_bound(in->keys, in->keys + in->count - 1, key) - in->keys;
+      for (size_t i = 0; i < c; ++i) {
+        rank += in->sizes[i];
+      }
+      n = in->children[c];
+    }
+    auto leaf = static_cast<leaf_node *>(n);
+    return rank + (std::lower_bound(leaf->keys, leaf->keys + leaf->count, key) - leaf->keys);
+  }
+  auto find(const T &key) const -> iterator {
+    auto it = lower_bound(key);
+    return it != end() && !(key < *it) ? it : end();
+  }
+  // Insert a key, return false if it is already there.
+  auto insert(const T &key) -> bool {
+    auto leaf = find_(key);
+    size_t pos = std::lower_bound(leaf->keys, leaf->keys + leaf->count, key) - leaf->keys;
+    if (pos < leaf->count && !(key < leaf->keys[pos])) {
+      return false;
+    }
+    std::copy_backward(leaf->keys + pos, leaf->keys + leaf->count, leaf->keys + leaf->count + 1);
+    leaf->keys[pos] = key;
+    ++size_;
+    ++leaf->count;
+    resize_(leaf, 1);
+    if (leaf->count > BTREE_LEAF) {
+      split_(leaf);
+    }
+    return true;
+  }
+  // Erase a key, return the number of erased keys.
+  auto erase(const T &key) -> size_t {
+    auto leaf = find_(key);
+    size_t pos = std::lower_bound(leaf->keys, leaf->keys + leaf->count, key) - leaf->keys;
+    if (pos == leaf->count || key < leaf->keys[pos]) {
+      return 0;
+    }
+    std::copy(leaf->keys + pos + 1, leaf->keys + leaf->count, leaf->keys + pos);
+    --size_;
+    --leaf->count;
+    resize_(leaf, -1);
+    if (leaf->count < BTREE_LEAF / 4 && leaf->parent) {
+      rebalance_(leaf);
+    }
+    return 1;
+  }
+private:
+  template<class N>
+  auto create_() -> N * {
+    typename std::allocator_traits<A>::template rebind_alloc<N> allocator(allocator_);
+    return new(allocator.allocate(1)) N;
+  }
+  template<class N>
+  void destroy_(N *n) {
+    typename std::allocator_traits<A>::template rebind_alloc<N> allocator(allocator_);
+    n->~N();
+    allocator.deallocate(n, 1);
+  }
+  void free_(node *n) {
+    if (n->leaf) {
+      destroy_(static_cast<leaf_node *>(n));
+      return;
+    }
+    auto in = static_cast<inner *>(n);
+    for (size_t i = 0; i < in->count; ++i) {
+      free_(in->children[i]);
+    }
+    destroy_(in);
+  }
+  static auto position_(const inner *parent, const node *child) -> size_t {
+    return std::find(parent->children, parent->children + parent->count, child) - parent->children;
+  }
+  // The number of keys below a node.
+  static auto weight_(const node *n) -> size_t {
+    if (n->leaf) {
+      return n->count;
+    }
+    auto in = static_cast<const inner *>(n);
+    size_t size = 0;
+    for (size_t i = 0; i < in->count; ++i) {
+      size += in->sizes[i];
+    }
+    return size;
+  }
+  // Count keys added below a node in all its ancestors.
+  static void resize_(node *n, int delta) {
+    for (; n->parent; n = n->parent) {
+      n->parent->sizes[position_(n->parent, n)] += delta;
+    }
+  }
+  auto find_(const T &key) const -> leaf_node * {
+    auto n = root_;
+    while (!n->leaf) {
+      auto in = static_cast<inner *>(n);
+      n = in->children[std::upper_bound(in->keys, in->keys + in->count - 1, key) - in->keys];
+    }
+    return static_cast<leaf_node *>(n);
+  }
+  // Move the upper half of an overfull leaf to a new leaf.
+  void split_(leaf_node *leaf) {
+    auto right = create_<leaf_node>();
+    size_t half = leaf->count / 2;
+    std::copy(leaf->keys + half, leaf->keys + leaf->count, right->keys);
+    right->count = leaf->count - half;
+    leaf->count = half;
+    right->prev = leaf;
+    right->next = leaf->next;
+    (leaf->next ? leaf->next->prev : last_) = right;
+    leaf->next = right;
+    attach_(leaf, right->keys[0], right);
+  }
+  // Add a node right after its left sibling, splitting the parent if it
+  // overflows.
+  void attach_(node *left, const T &separator, node *right) {
+    auto parent = left->parent;
+    if (!parent) {
+      root_ = parent = create_<inner>();
+      parent->children[0] = left;
+      parent->sizes[0] = weight_(left) + weight_(right);
+      parent->count = 1;
+      left->parent = parent;
+    }
+    size_t i = position_(parent, left);
+    std::copy_backward(parent->children + i + 1, parent->children + parent->count,
+                       parent->children + parent->count + 1);
+    std::copy_backward(parent->sizes + i + 1, parent->sizes + parent->count, parent->sizes + parent->count + 1);
+    std::copy_backward(parent->keys + i, parent->keys + parent->count - 1, parent->keys + parent->count);
+    parent->children[i + 1] = right;
+    parent->sizes[i + 1] = weight_(right);
+    parent->sizes[i] -= parent->sizes[i + 1];
+    parent->keys[i] = separator;
+    right->parent = parent;
+    if (++parent->count <= BTREE_FANOUT) {
+      return;
+    }
+    auto sibling = create_<inner>();
+    size_t half = parent->count / 2;
+    sibling->count = parent->count - half;
+    std::copy(parent->children + half, parent->children + parent->count, sibling->children);
+    std::copy(parent->sizes + half, parent->sizes + parent->count, sibling->sizes);
+    std::copy(parent->keys + half, parent->keys + parent->count - 1, sibling->keys);
+    for (size_t c = 0; c < sibling->count; ++c) {
+      sibling->children[c]->parent = sibling;
+    }
+    parent->count = half;
+    T up = parent->keys[half - 1];
+    attach_(parent, up, sibling);
+  }
+  // Remove the child i > 0 and its separator from a node, its keys must
+  // have been moved to the child i - 1.
+  void detach_(inner *parent, size_t i) {
+    std::copy(parent->children + i + 1, parent->children + parent->count, parent->children + i);
+    std::copy(parent->sizes + i + 1, parent->sizes + parent->count, parent->sizes + i);
+    std::copy(parent->keys + i, parent->keys + parent->count - 1, parent->keys + i - 1);
+    if (--parent->count < BTREE_FANOUT / 4 && parent->parent) {
+      rebalance_(parent);
+    } else if (parent->count == 1 && parent == root_) {
+      root_ = parent->children[0];
+      root_->parent = nullptr;
+      destroy_(parent);
+    }
+  }
+  // Merge an underfull node with a sibling, or even them out if both do not
+  // fit in three quarters of a node.
+  void rebalance_(node *n) {
+    auto parent = n->parent;
+    size_t i = position_(parent, n);
+    if (i + 1 == parent->count) {
+      --i;
+    }
+    auto left = parent->children[i];
+    auto right = parent->children[i + 1];
+    if (n->leaf) {
+      auto l = static_cast<leaf_node *>(left);
+      auto r = static_cast<leaf_node *>(right);
+      if (l->count + r->count <= BTREE_LEAF * 3 / 4) {
+        std::copy(r->keys, r->keys + r->count, l->keys + l->count);
+        l->count += r->count;
+        l->next = r->next;
+        (r->next ? r->next->prev : last_) = l;
+        parent->sizes[i] += parent->sizes[i + 1];
+        destroy_(r);
+        detach_(parent, i + 1);
+        return;
+      }
+      size_t total = l->count + r->count;
+      size_t half = total / 2;
+      if (l->count < half) {
+        std::copy(r->keys, r->keys + half - l->count, l->keys + l->count);
+        std::copy(r->keys + half - l->count, r->keys + r->count, r->keys);
+      } else {
+        std::copy_backward(r->keys, r->keys + r->count, r->keys + total - half);
+        std::copy(l->keys + half, l->keys + l->count, r->keys);
+      }
+      l->count = half;
+      r->count = total - half;
+      parent->sizes[i] = l->count;
+      parent->sizes[i + 1] = r->count;
+      parent->keys[i] = r->keys[0];
+      return;
+    }
+    auto l = static_cast<inner *>(left);
+    auto r = static_cast<inner *>(right);
+    // Both nodes with the separator between them.
+    T keys[2 * BTREE_FANOUT];
+    node *children[2 * BTREE_FANOUT];
+    size_t sizes[2 * BTREE_FANOUT];
+    size_t total = l->count + r->count;
+    std::copy(l->keys, l->keys + l->count - 1, keys);
+    keys[l->count - 1] = parent->keys[i];
+    std::copy(r->keys, r->keys + r->count - 1, keys + l->count);
+    std::copy(l->children, l->children + l->count, children);
+    std::copy(r->children, r->children + r->count, children + l->count);
+    std::copy(l->sizes, l->sizes + l->count, sizes);
+    std::copy(r->sizes, r->sizes + r->count, sizes + l->count);
+    if (total <= BTREE_FANOUT * 3 / 4) {
+      std::copy(keys, keys + total - 1, l->keys);
+      std::copy(children, children + total, l->children);
+      std::copy(sizes, sizes + total, l->sizes);
+      for (size_t c = l->count; c < total; ++c) {
+        children[c]->parent = l;
+      }
+      l->count = total;
+      parent->sizes[i] += parent->sizes[i + 1];
+      destroy_(r);
+      detach_(parent, i + 1);
+      return;
+    }
+    size_t half = total / 2;
+    std::copy(keys, keys + half - 1, l->keys);
+    std::copy(children, children + half, l->children);
+    std::copy(sizes, sizes + half, l->sizes);
+    std::copy(keys + half, keys + total - 1, r->keys);
+    std::copy(children + half, children + total, r->children);
+    std::copy(sizes + half, sizes + total, r->sizes);
+    for (size_t c = 0; c < total; ++c) {
+      children[c]->parent = c < half ? l : r;
+    }
+    l->count = half;
+    r->count = total - half;
+    parent->sizes[i] = weight_(l);
+    parent->sizes[i + 1] = weight_(r);
+    parent->keys[i] = keys[half - 1];
+  }
+  A allocator_;
+  node *root_ = nullptr;
+  leaf_node *first_ = nullptr;
+  leaf_node *last_ = nullptr;
+  size_t size_ = 0;
+};
+
+}
+
+#endif //SDIS_BTREE_H
@@ -26,7 +26,6 @@
  * $Id: log.h 998 2014-12-18 12:07:14Z li $
  */
 
-#include <cmath>
 #include "sdis-cache.h"
 
 namespace sdistream {
@@ -53,25 +52,16 @@ auto operator<<(std::ostream &out, const cache_entry &row) -> std::ostream & {
   return out;
 }
 
-auto estimate(const cache_entry &ent, const std::set<cache_entry> &dim) -> double {
+// The share of a dimension ordered before an entry, exact from its rank
+// whatever the distribution of the values.
+auto estimate(const cache_entry &ent, const btree<cache_entry> &dim) -> double {
   if (dim.empty()) {
     return 0;
   }
-  auto &&first = *(dim.begin());
-  auto &&last = *(dim.rbegin());
-  if (first == last) {
-    return 1;
-  }
-  if (ent < first) {
-    return 0;
-  }
-  if (last < ent) {
-    return 1;
-  }
-  return 1.0 * std::abs(ent.value - first.value) / std::abs(last.value - first.value);
+  return 1.0 * dim.rank(ent) / dim.size();
 }
 
-auto lower_dimension(const cache_entry *entries, const std::set<cache_entry> *indexes, size_t width) -> size_t {
+auto lower_dimension(const cache_entry *entries, const btree<cache_entry> *indexes, size_t width) -> size_t {
   size_t d = 0;
   double lower = 1;
   for (size_t i = 0; i < width; ++i) {
@@ -88,7 +78,7 @@ auto lower_dimension(const cache_entry *entries, const std::set<cache_entry> *in
   return d;
 }
 
-auto upper_dimension(const cache_entry *entries, const std::set<cache_entry> *indexes, size_t width) -> size_t {
+auto upper_dimension(const cache_entry *entries, const btree<cache_entry> *indexes, size_t width) -> size_t {
   size_t d = 0;
   double upper = 0;
   for (size_t i = 0; i < width; ++i) {
@@ -105,6 +95,18 @@ auto upper_dimension(const cache_entry *entries, const std::set<cache_entry> *in
   return d;
 }
 
+void insert_dimensions(btree<cache_entry> *indexes, index_t index, const value_t *tuple, size_t width) {
+  for (size_t i = 0; i < width; ++i) {
+    indexes[i].insert(cache_entry(index, tuple[i]));
+  }
+}
+
+void erase_dimensions(btree<cache_entry> *indexes, index_t index, const value_t *tuple, size_t width) {
+  for (size_t i = 0; i < width; ++i) {
+    indexes[i].erase(cache_entry(index, tuple[i]));
+  }
+}
+
 }
 
 #ifndef WITH_TIME_WINDOW
@@ -157,10 +159,15 @@ auto cache::skyline(index_t index) -> bool & {
 
 #else
 
+#include <sys/mman.h>
 #include <sys/time.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <ctime>
 #include <cstring>
 #include <iostream>
+#include <new>
 #include "sdis-cache.h"
 
 namespace sdistream {
@@ -173,88 +180,149 @@ auto cache::timestamp() -> double {
   return (double) (t.tv_sec - zero_) + t.tv_usec / 1000000.0;
 }
 
-cache::cache(size_t width, size_t window) : free_(CACHE), skyline_(width), stamp_(width + 1), width_(width), width2_(width + 2), window_(window) {
-  cache_ = new value_t[width2_ * CACHE]; // Tuple + Skyline flag (-1/1) + Timestamp
-  for (size_t i = 0; i < CACHE; ++i) {
-    free_[i] = &cache_[width2_ * i];
+cache::cache(size_t width, size_t window) : width_(width), window_(window) {
+  size_t rows = CACHE_CHUNK / ((width_ + 1) * sizeof(double));
+  while (2 * rows_ <= rows) {
+    rows_ *= 2;
+    ++shift_;
   }
+  mask_ = rows_ - 1;
+  // Whole huge pages, more than one for very wide rows.
+  bytes_ = (rows_ * (width_ + 1) * sizeof(double) + CACHE_CHUNK - 1) / CACHE_CHUNK * CACHE_CHUNK;
   struct timeval t{};
   gettimeofday(&t, (struct timezone *) nullptr);
   zero_ = t.tv_sec;
 }
 
 cache::~cache() {
-  delete[] cache_;
+  for (auto &&c : chunks_) {
+    unmap_(c);
+  }
+  if (spare_) {
+    unmap_(spare_);
+  }
 }
 
 void cache::clean() {
-  for (auto &&it = list_.begin(); it != list_.end();) {
-    auto &&early = (*it)[stamp_];
-    if (latest_ - early > window_) {
-      free_.push_back(*it);
-      index_[slice_(early)].erase(early);
-      it = list_.erase(it);
-    } else {
-      break;
+  expire_();
+  size_ -= expired_;
+  for (; expired_; --expired_) {
+    if (++head_ == rows_) {
+      head_ = 0;
+      if (spare_) {
+        unmap_(chunks_.front());
+      } else {
+        spare_ = chunks_.front();
+      }
+      chunks_.pop_front();
     }
   }
 }
 
 auto cache::contains(double stamp) -> bool {
-  return index_[slice_(stamp)].count(stamp);
+  return find_(stamp) < size_;
 }
 
-auto cache::expired() -> std::vector<double> & {
-  expired_.clear();
-  for (auto &&it = list_.begin(); it != list_.end(); ++it) {
-    auto &&early = (*it)[stamp_];
-    if (latest_ - early > window_) {
-      expired_.push_back(early);
-    } else {
-      break;
-    }
-  }
-  return expired_;
+auto cache::expired() -> cache::span {
+  expire_();
+  return span(this, expired_);
 }
 
 auto cache::get(double stamp) -> value_t * {
-  auto &&it = index_[slice_(stamp)].find(stamp);
-  if (it == index_[slice_(stamp)].end()) {
+  auto n = find_(stamp);
+  if (n == size_) {
     return nullptr;
   }
-  return it->second;
+  return row_(n);
+}
+
+auto cache::peak() -> size_t {
+  return peak_ * bytes_;
 }
 
 auto cache::put(value_t *buffer) -> double {
-  latest_ = timestamp();
-  auto &&row = free_.back();
-  std::memcpy(row, buffer, sizeof(value_t) * width_);
-  free_.pop_back();
-  index_[slice_(latest_)].insert(std::make_pair(latest_, row));
-  list_.push_back(row);
-  row[stamp_] = latest_;
+  // Tuples of the same microsecond get the next representable stamps.
+  auto stamp = timestamp();
+  latest_ = count_ && stamp <= latest_ ? std::nextafter(latest_, HUGE_VAL) : stamp;
+  auto p = head_ + size_;
+  if (p >> shift_ == chunks_.size()) {
+    chunks_.push_back(spare_ ? spare_ : map_());
+    spare_ = nullptr;
+  }
+  chunks_[p >> shift_][p & mask_] = latest_;
+  std::memcpy(row_(size_), buffer, sizeof(value_t) * width_);
+  ++size_;
   ++count_;
   return latest_;
 }
 
 auto cache::put(value_t *buffer, bool skyline) -> double {
-  latest_ = timestamp();
-  auto &&row = free_.back();
-  std::memcpy(row, buffer, sizeof(value_t) * width_);
-  free_.pop_back();
-  index_[slice_(latest_)].insert(std::make_pair(latest_, row));
-  list_.push_back(row);
-  row[stamp_] = latest_;
-  ++count_;
-  return latest_;
+  return put(buffer);
 }
 
 auto cache::size() -> size_t {
-  return CACHE - free_.size();
+  return size_;
+}
+
+// Move the expiry cursor past the rows that expired since the last call.
+void cache::expire_() {
+  while (expired_ < size_ && latest_ - stamp_(expired_) > window_) {
+    ++expired_;
+  }
+}
+
+// The position of a stamp from the first row, or size_ if it is not cached.
+// Stamps grow at the pace of the stream, so interpolating between the
+// bounds lands close to the stamp. Interpolation alternates with bisection
+// to keep the search logarithmic on bursty streams.
+auto cache::find_(double stamp) -> size_t {
+  size_t low = 0;
+  size_t high = size_;
+  for (bool bisect = false; low < high; bisect = !bisect) {
+    double first = stamp_(low);
+    double last = stamp_(high - 1);
+    if (stamp < first || stamp > last) {
+      return size_;
+    }
+    size_t n = low + (high - low) / 2;
+    if (!bisect && last > first) {
+      n = low + static_cast<size_t>((stamp - first) / (last - first) * (high - 1 - low));
+    }
+    double s = stamp_(n);
+    if (s == stamp) {
+      return n;
+    } else if (s < stamp) {
+      low = n + 1;
+    } else {
+      high = n;
+    }
+  }
+  return size_;
+}
+
+// Map a chunk aligned on CACHE_CHUNK bytes, so that the kernel can back it
+// with huge pages.
+auto cache::map_() -> double * {
+  auto p = static_cast<char *>(mmap(nullptr, bytes_ + CACHE_CHUNK, PROT_READ | PROT_WRITE,
+                                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+  if (p == MAP_FAILED) {
+    throw std::bad_alloc();
+  }
+  auto head = (CACHE_CHUNK - reinterpret_cast<uintptr_t>(p) % CACHE_CHUNK) % CACHE_CHUNK;
+  if (head) {
+    munmap(p, head);
+  }
+  munmap(p + head + bytes_, CACHE_CHUNK - head);
+#ifdef MADV_HUGEPAGE
+  madvise(p + head, bytes_, MADV_HUGEPAGE);
+#endif
+  peak_ = std::max(peak_, ++mapped_);
+  return reinterpret_cast<double *>(p + head);
 }
 
-auto cache::slice_(double index) -> size_t {
-  return (int) index % BLOCK;
+void cache::unmap_(double *chunk) {
+  munmap(chunk, bytes_);
+  --mapped_;
 }
 
 }
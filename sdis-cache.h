@@ -29,16 +29,12 @@
 #ifndef SDIS_CACHE_H
 #define SDIS_CACHE_H
 
-#ifndef CACHE
-#define CACHE 1000000
-#endif
-
-#ifndef BLOCK
-#define BLOCK 16
+#ifndef CACHE_CHUNK
+#define CACHE_CHUNK (2 << 20)
 #endif
 
 #include <iostream>
-#include <set>
+#include "sdis-btree.h"
 #include "types.h"
 
 namespace sdistream {
@@ -59,9 +55,12 @@ auto operator==(const cache_entry &, const cache_entry &) -> bool;
 auto operator<(const cache_entry &, const cache_entry &) -> bool;
 auto operator<<(std::ostream &, const cache_entry &) -> std::ostream &;
 
-auto estimate(const cache_entry &, const std::set<cache_entry> &) -> double;
-auto lower_dimension(const cache_entry *, const std::set<cache_entry> *, size_t) -> size_t;
-auto upper_dimension(const cache_entry *, const std::set<cache_entry> *, size_t) -> size_t;
+auto estimate(const cache_entry &, const btree<cache_entry> &) -> double;
+auto lower_dimension(const cache_entry *, const btree<cache_entry> *, size_t) -> size_t;
+auto upper_dimension(const cache_entry *, const btree<cache_entry> *, size_t) -> size_t;
+// Put a tuple into dimensional indexes, or erase it from them.
+void insert_dimensions(btree<cache_entry> *, index_t, const value_t *, size_t);
+void erase_dimensions(btree<cache_entry> *, index_t, const value_t *, size_t);
 
 }
 
@@ -92,43 +91,107 @@ private:
 
 #else
 
-#include <array>
-#include <list>
-#include <map>
-#include <unordered_map>
-#include <unordered_set>
-#include <vector>
+#include <deque>
 #include "types.h"
 
 namespace sdistream {
 
+// Rows of a time window in chunks of CACHE_CHUNK bytes, the huge page
+// size, mapped on huge pages where possible. Chunks are mapped as the
+// window grows and unmapped as it shrinks, but one is kept spare. Stamps
+// strictly increase, so rows are found by searching the stamps and expire
+// from the front. Rows do not move until they expire.
 class cache {
 public:
+  // Stamps of the first rows.
+  class span {
+  public:
+    class iterator {
+    public:
+      iterator(const cache *c, size_t n) : cache_(c), n_(n) {
+      }
+      auto operator*() const -> double {
+        return cache_->stamp_(n_);
+      }
+      auto operator++() -> iterator & {
+        ++n_;
+        return *this;
+      }
+      auto operator!=(const iterator &i) const -> bool {
+        return n_ != i.n_;
+      }
+    private:
+      const cache *cache_;
+      size_t n_;
+    };
+    span(const cache *c, size_t n) : cache_(c), size_(n) {
+    }
+    auto begin() const -> iterator {
+      return iterator(cache_, 0);
+    }
+    auto end() const -> iterator {
+      return iterator(cache_, size_);
+    }
+    // The stamp of the last expired tuple.
+    auto back() const -> double {
+      return cache_->stamp_(size_ - 1);
+    }
+    auto empty() const -> bool {
+      return size_ == 0;
+    }
+    auto size() const -> size_t {
+      return size_;
+    }
+  private:
+    const cache *cache_;
+    size_t size_;
+  };
   static auto timestamp() -> double;
   cache() = default;
   cache(size_t, size_t);
+  cache(const cache &) = delete;
+  auto operator=(const cache &) -> cache & = delete;
   virtual ~cache();
+  // Remove the expired rows.
   void clean();
   auto contains(double) -> bool;
-  auto expired() -> std::vector<double> &;
+  // The expired rows, found by a cursor that passes each row once.
+  auto expired() -> span;
   auto get(double) -> value_t *;
+  // The most bytes mapped at once.
+  auto peak() -> size_t;
   auto put(value_t *) -> double;
-  auto put(value_t *, bool) -> double;;
+  auto put(value_t *, bool) -> double;
   auto size() -> size_t;
 private:
-  static auto slice_(double) -> size_t;
   static size_t zero_;
-  value_t *cache_ = nullptr;
+  void expire_();
+  auto find_(double) -> size_t;
+  auto map_() -> double *;
+  void unmap_(double *);
+  // A chunk holds the stamps of its rows, then the rows.
+  inline auto stamp_(size_t n) const -> double {
+    auto p = head_ + n;
+    return chunks_[p >> shift_][p & mask_];
+  }
+  inline auto row_(size_t n) const -> value_t * {
+    auto p = head_ + n;
+    return chunks_[p >> shift_] + rows_ + (p & mask_) * width_;
+  }
+  size_t bytes_ = 0; // Mapped bytes per chunk.
+  std::deque<double *> chunks_;
   size_t count_ = 0;
-  std::vector<double> expired_;
-  std::vector<value_t *> free_;
-  std::array<std::unordered_map<double, value_t *>, BLOCK> index_;
+  size_t expired_ = 0; // Rows before the expiry cursor.
+  size_t head_ = 0; // The first row in the first chunk.
   double latest_ = 0;
-  std::list<value_t *> list_;
-  size_t skyline_ = 0;
-  size_t stamp_ = 0;
+  size_t mapped_ = 0;
+  size_t mask_ = 0;
+  size_t peak_ = 0;
+  size_t rows_ = 1; // Rows per chunk, a power of two.
+  size_t shift_ = 0;
+  size_t size_ = 0;
+  double *spare_ = nullptr;
   size_t width_ = 0;
-  size_t width2_ = 0;
   double window_ = 0;
 };
 
@@ -0,0 +1,340 @@
+/*-
+ * Copyright (c) 2019 Rui Liu and Dominique Li <dominique.li@univ-tours.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id: log.h 998 2014-12-18 12:07:14Z li $
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#include "sdis-dominance.h"
+
+namespace sdistream {
+
+static_assert(std::is_same<value_t, double>::value, "Dominance kernels compare doubles");
+
+// Kernels are instantiated for rows of D values, where every loop over the
+// dimensions has a constant trip count, and for D = 0 on the width given at
+// run time.
+template<size_t D>
+constexpr auto fixed(size_t width) -> size_t {
+  return D ? D : width;
+}
+
+template<size_t D>
+static auto dominance_scalar(const value_t *row1, const value_t *row2, size_t width) -> bool {
+  width = fixed<D>(width);
+  bool dominating = false;
+  for (size_t i = 0; i < width; ++i) {
+    if (row1[i] > row2[i]) {
+      return false;
+    } else if (row1[i] < row2[i]) {
+      dominating = true;
+    }
+  }
+  return dominating;
+}
+
+static inline void batch_clear(size_t count, uint64_t *mask) {
+  for (size_t w = 0; w < (count + 63) / 64; ++w) {
+    mask[w] = 0;
+  }
+}
+
+// Points from last to first one at a time, return last if none dominates
+// the tuple.
+template<size_t D>
+static inline auto batch_range(const value_t *columns, size_t stride, size_t first, size_t last, size_t width,
+                               const value_t *tuple, uint64_t *mask) -> size_t {
+  width = fixed<D>(width);
+  for (size_t p = last; p-- > first;) {
+    bool greater = false; // The point is greater than the tuple on a dimension.
+    bool less = false; // The point is less than the tuple on a dimension.
+    for (size_t i = 0; i < width && !(greater && less); ++i) {
+      auto v = columns[i * stride + p];
+      greater = greater || v > tuple[i];
+      less = less || v < tuple[i];
+    }
+    if (less && !greater) {
+      return p;
+    }
+    if (greater && !less) {
+      mask[p / 64] |= uint64_t(1) << (p % 64);
+    }
+  }
+  return last;
+}
+
+template<size_t D>
+static auto batch_scalar(const value_t *columns, size_t stride, size_t count, size_t width, const value_t *tuple,
+                         uint64_t *mask) -> size_t {
+  batch_clear(count, mask);
+  return batch_range<D>(columns, stride, 0, count, width, tuple, mask);
+}
+
+#ifdef __SSE2__
+
+// Two values per comparison.
+template<size_t D>
+static auto dominance_sse2(const value_t *row1, const value_t *row2, size_t width) -> bool {
+  width = fixed<D>(width);
+  auto less = _mm_setzero_pd();
+  size_t i = 0;
+  for (; i + 2 <= width; i += 2) {
+    auto x = _mm_loadu_pd(row1 + i);
+    auto y = _mm_loadu_pd(row2 + i);
+    if (_mm_movemask_pd(_mm_cmpgt_pd(x, y))) {
+      return false;
+    }
+    less = _mm_or_pd(less, _mm_cmplt_pd(x, y));
+  }
+  bool dominating = _mm_movemask_pd(less) != 0;
+  if (i < width) {
+    if (row1[i] > row2[i]) {
+      return false;
+    }
+    dominating = dominating || row1[i] < row2[i];
+  }
+  return dominating;
+}
+
+// Two points per comparison.
+template<size_t D>
+static auto batch_sse2(const value_t *columns, size_t stride, size_t count, size_t width, const value_t *tuple,
+                       uint64_t *mask) -> size_t {
+  width = fixed<D>(width);
+  batch_clear(count, mask);
+  // The last point alone, then aligned pairs.
+  size_t p = count - count % 2;
+  auto last = batch_range<D>(columns, stride, p, count, width, tuple, mask);
+  if (last < count) {
+    return last;
+  }
+  while (p > 0) {
+    p -= 2;
+    auto greater = _mm_setzero_pd();
+    auto less = _mm_setzero_pd();
+    for (size_t i = 0; i < width; ++i) {
+      auto v = _mm_loadu_pd(columns + i * stride + p);
+      auto t = _mm_set1_pd(tuple[i]);
+      greater = _mm_or_pd(greater, _mm_cmpgt_pd(v, t));
+      less = _mm_or_pd(less, _mm_cmplt_pd(v, t));
+      if (_mm_movemask_pd(_mm_and_pd(greater, less)) == 0x3) {
+        break;
+      }
+    }
+    unsigned g = _mm_movemask_pd(greater);
+    unsigned l = _mm_movemask_pd(less);
+    if (l & ~g) {
+      return p + 31 - __builtin_clz(l & ~g);
+    }
+    mask[p / 64] |= uint64_t(g & ~l) << (p % 64);
+  }
+  return count;
+}
+
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define WITH_AVX_DOMINANCE
+
+// Four values per comparison, the remaining ones two by two.
+template<size_t D>
+__attribute__((target("avx2")))
+static auto dominance_avx2(const value_t *row1, const value_t *row2, size_t width) -> bool {
+  width = fixed<D>(width);
+  auto less = _mm256_setzero_pd();
+  size_t i = 0;
+  for (; i + 4 <= width; i += 4) {
+    auto x = _mm256_loadu_pd(row1 + i);
+    auto y = _mm256_loadu_pd(row2 + i);
+    if (_mm256_movemask_pd(_mm256_cmp_pd(x, y, _CMP_GT_OQ))) {
+      return false;
+    }
+    less = _mm256_or_pd(less, _mm256_cmp_pd(x, y, _CMP_LT_OQ));
+  }
+  bool dominating = _mm256_movemask_pd(less) != 0;
+  for (; i < width; ++i) {
+    if (row1[i] > row2[i]) {
+      return false;
+    } else if (row1[i] < row2[i]) {
+      dominating = true;
+    }
+  }
+  return dominating;
+}
+
+// Four points per comparison.
+template<size_t D>
+__attribute__((target("avx2")))
+static auto batch_avx2(const value_t *columns, size_t stride, size_t count, size_t width, const value_t *tuple,
+                       uint64_t *mask) -> size_t {
+  width = fixed<D>(width);
+  batch_clear(count, mask);
+  // The last points one at a time, then aligned groups.
+  size_t p = count - count % 4;
+  auto last = batch_range<D>(columns, stride, p, count, width, tuple, mask);
+  if (last < count) {
+    return last;
+  }
+  while (p > 0) {
+    p -= 4;
+    auto greater = _mm256_setzero_pd();
+    auto less = _mm256_setzero_pd();
+    for (size_t i = 0; i < width; ++i) {
+      auto v = _mm256_loadu_pd(columns + i * stride + p);
+      auto t = _mm256_set1_pd(tuple[i]);
+      greater = _mm256_or_pd(greater, _mm256_cmp_pd(v, t, _CMP_GT_OQ));
+      less = _mm256_or_pd(less, _mm256_cmp_pd(v, t, _CMP_LT_OQ));
+      if (_mm256_movemask_pd(_mm256_and_pd(greater, less)) == 0xF) {
+        break;
+      }
+    }
+    unsigned g = _mm256_movemask_pd(greater);
+    unsigned l = _mm256_movemask_pd(less);
+    if (l & ~g) {
+      return p + 31 - __builtin_clz(l & ~g);
+    }
+    mask[p / 64] |= uint64_t(g & ~l) << (p % 64);
+  }
+  return count;
+}
+
+// Eight values per comparison, the remaining ones under a load mask that
+// leaves both rows equal on unused lanes.
+template<size_t D>
+__attribute__((target("avx512f")))
+static auto dominance_avx512(const value_t *row1, const value_t *row2, size_t width) -> bool {
+  width = fixed<D>(width);
+  __mmask8 less = 0;
+  size_t i = 0;
+  for (; i + 8 <= width; i += 8) {
+    auto x = _mm512_loadu_pd(row1 + i);
+    auto y = _mm512_loadu_pd(row2 + i);
+    if (_mm512_cmp_pd_mask(x, y, _CMP_GT_OQ)) {
+      return false;
+    }
+    less |= _mm512_cmp_pd_mask(x, y, _CMP_LT_OQ);
+  }
+  if (i < width) {
+    auto mask = (__mmask8) ((1u << (width - i)) - 1);
+    auto x = _mm512_maskz_loadu_pd(mask, row1 + i);
+    auto y = _mm512_maskz_loadu_pd(mask, row2 + i);
+    if (_mm512_cmp_pd_mask(x, y, _CMP_GT_OQ)) {
+      return false;
+    }
+    less |= _mm512_cmp_pd_mask(x, y, _CMP_LT_OQ);
+  }
+  return less != 0;
+}
+
+// Eight points per comparison, the last ones under a load mask.
+template<size_t D>
+__attribute__((target("avx512f")))
+static auto batch_avx512(const value_t *columns, size_t stride, size_t count, size_t width, const value_t *tuple,
+                         uint64_t *mask) -> size_t {
+  width = fixed<D>(width);
+  batch_clear(count, mask);
+  size_t p = count;
+  while (p > 0) {
+    // The last points, then aligned groups.
+    auto n = p % 8 ? p % 8 : 8;
+    p -= n;
+    auto valid = (__mmask8) ((1u << n) - 1);
+    __mmask8 greater = 0;
+    __mmask8 less = 0;
+    for (size_t i = 0; i < width; ++i) {
+      auto v = _mm512_maskz_loadu_pd(valid, columns + i * stride + p);
+      auto t = _mm512_set1_pd(tuple[i]);
+      greater |= _mm512_mask_cmp_pd_mask(valid, v, t, _CMP_GT_OQ);
+      less |= _mm512_mask_cmp_pd_mask(valid, v, t, _CMP_LT_OQ);
+      if ((greater & less) == valid) {
+        break;
+      }
+    }
+    unsigned dominating = less & ~greater;
+    if (dominating) {
+      return p + 31 - __builtin_clz(dominating);
+    }
+    mask[p / 64] |= uint64_t(greater & ~less) << (p % 64);
+  }
+  return count;
+}
+
+#endif
+
+// The instances of a kernel from the runtime width to WIDTH values.
+#define DOMINANCE_WIDTHS(k) \
+  {k<0>, k<1>, k<2>, k<3>, k<4>, k<5>, k<6>, k<7>, k<8>, k<9>, k<10>, k<11>, k<12>, k<13>, k<14>, k<15>, k<16>}
+static_assert(dominance::WIDTH == 16, "DOMINANCE_WIDTHS lists the instances up to dominance::WIDTH");
+
+dominance::kernel dominance::kernels_[WIDTH + 1] = DOMINANCE_WIDTHS(dominance_scalar);
+dominance::batch_kernel dominance::batches_[WIDTH + 1] = DOMINANCE_WIDTHS(batch_scalar);
+const char *dominance::name_ = "scalar";
+
+// Select the best kernel before main().
+static bool selected = dominance::select(nullptr);
+
+auto dominance::name() -> const char * {
+  return name_;
+}
+
+auto dominance::select(const char *name) -> bool {
+  struct candidate {
+    const char *name;
+    kernel k[WIDTH + 1];
+    batch_kernel b[WIDTH + 1];
+    bool supported;
+  };
+#ifdef WITH_AVX_DOMINANCE
+  __builtin_cpu_init();
+#endif
+  // From the best kernel to the baseline.
+  const candidate candidates[] = {
+#ifdef WITH_AVX_DOMINANCE
+      {"avx512", DOMINANCE_WIDTHS(dominance_avx512), DOMINANCE_WIDTHS(batch_avx512),
+       __builtin_cpu_supports("avx512f") != 0},
+      {"avx2", DOMINANCE_WIDTHS(dominance_avx2), DOMINANCE_WIDTHS(batch_avx2), __builtin_cpu_supports("avx2") != 0},
+#endif
+#ifdef __SSE2__
+      {"sse2", DOMINANCE_WIDTHS(dominance_sse2), DOMINANCE_WIDTHS(batch_sse2), true},
+#endif
+      {"scalar", DOMINANCE_WIDTHS(dominance_scalar), DOMINANCE_WIDTHS(batch_scalar), true}
+  };
+  for (auto &&c : candidates) {
+    if (c.supported && (!name || !strcmp(name, c.name))) {
+      std::copy(c.k, c.k + WIDTH + 1, kernels_);
+      std::copy(c.b, c.b + WIDTH + 1, batches_);
+      name_ = c.name;
+      return true;
+    }
+  }
+  return false;
+}
+
+}
@@ -0,0 +1,93 @@
+/*-
+ * Copyright (c) 2019 Rui Liu and Dominique Li <dominique.li@univ-tours.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id: log.h 998 2014-12-18 12:07:14Z li $
+ */
+
+#ifndef SDIS_DOMINANCE_H
+#define SDIS_DOMINANCE_H
+
+#include <algorithm>
+#include <cstdint>
+#include "types.h"
+
+namespace sdistream {
+
+// Dominance test of two rows of values: no value of the first row is greater
+// and at least one is less. Kernels compare whole vectors of values and are
+// selected once from the CPU features, all of them give the same results.
+// Batch kernels test one tuple against many points stored column-wise,
+// comparing consecutive points of a column at once. Each kernel has an
+// instance with unrolled loops per width up to WIDTH values.
+class dominance {
+public:
+  static const size_t WIDTH = 16;
+  typedef auto (*kernel)(const value_t *, const value_t *, size_t) -> bool;
+  typedef auto (*batch_kernel)(const value_t *, size_t, size_t, size_t, const value_t *, uint64_t *) -> size_t;
+  // The name of the selected kernel.
+  static auto name() -> const char *;
+  // Select a kernel by name (scalar, sse2, avx2 or avx512), or the best
+  // supported one without a name. Return false if the CPU lacks it.
+  static auto select(const char *) -> bool;
+  // The first row dominates the second row.
+  static inline auto test(const value_t *row1, const value_t *row2, size_t width) -> bool {
+    return kernels_[width <= WIDTH ? width : 0](row1, row2, width);
+  }
+  // Test a tuple against count points of width columns, each column stride
+  // values apart, from the last point to the first one. Return the last
+  // point dominating the tuple, or count and set the bits of the points the
+  // tuple dominates in (count + 63) / 64 mask words. Points of NaN values
+  // neither dominate nor are dominated.
+  static inline auto batch(const value_t *columns, size_t stride, size_t count, size_t width, const value_t *tuple,
+                           uint64_t *mask) -> size_t {
+    return batches_[width <= WIDTH ? width : 0](columns, stride, count, width, tuple, mask);
+  }
+  // The sum of the values of a row, never greater for a row dominating
+  // another one.
+  static inline auto score(const value_t *row, size_t width) -> value_t {
+    value_t s = 0;
+    for (size_t i = 0; i < width; ++i) {
+      s += row[i];
+    }
+    return s;
+  }
+  // Order rows by score then by values, so that no row is dominated by a
+  // later one, for sort-filter skylines.
+  static inline auto precede(const value_t *row1, value_t score1, const value_t *row2, value_t score2, size_t width)
+      -> bool {
+    if (score1 != score2) {
+      return score1 < score2;
+    }
+    return std::lexicographical_compare(row1, row1 + width, row2, row2 + width);
+  }
+private:
+  static kernel kernels_[WIDTH + 1];
+  static batch_kernel batches_[WIDTH + 1];
+  static const char *name_;
+};
+
+}
+
+#endif //SDIS_DOMINANCE_H
@@ -27,8 +27,11 @@
  */
 
 #include <sys/time.h>
+#include <algorithm>
 #include <ctime>
-#include <cmath>
+#include <cstring>
+#include <iterator>
+#include "sdis-dominance.h"
 #include "sdis-index.h"
 
 namespace sdistream {
@@ -37,13 +40,31 @@ size_t index::DT = 0;
 size_t index::count_ = 0;
 size_t index::zero_ = 0;
 
+// Slabs of a count window of blocks, the default size for time windows.
+static auto slab(stamp_t window) -> size_t {
+#ifndef WITH_TIME_WINDOW
+  return window + 1;
+#else
+  (void) window;
+  return POOL_SLAB;
+#endif
+}
+
+// Links in stamp order, tuples of the same time by address.
+static bool older(const index_header::link &l1, const index_header::link &l2) {
+  if (l1.second == l2.second) {
+    return l1.first < l2.first;
+  }
+  return l1.second < l2.second;
+}
+
 bool operator==(const index_entry &e1, const index_entry &e2) {
-  return e1.header->stamp == e2.header->stamp;
+  return e1.stamp == e2.stamp;
 }
 
 bool operator<(const index_entry &e1, const index_entry &e2) {
   if (e1.value == e2.value) {
-    return e1.header->stamp < e2.header->stamp;
+    return e1.stamp < e2.stamp;
   }
   return e1.value < e2.value;
 }
@@ -56,69 +77,6 @@ bool operator<(const index_header &h1, const index_header &h2) {
   return h1.stamp < h2.stamp;
 }
 
-bool dominate(const index::entry *e1, const index::entry *e2) {
-  return dominate(e1->header, e2->header);
-}
-
-bool dominate(const index::entry *entry, const value_t *buffer) {
-  return dominate(entry->header, buffer);
-}
-
-bool dominate(const value_t *buffer, const index::entry *entry) {
-  return dominate(buffer, entry->header);
-}
-
-bool dominate(const index::header *h1, const index::header *h2) {
-  const index::entry *p1 = h1->tuple;
-  const index::entry *p2 = h2->tuple;
-  ++index::DT;
-  bool dominating = false;
-  while (p1 && p2) {
-    if (p1->value > p2->value) {
-      return false;
-    } else if (p1->value < p2->value && !dominating) {
-      dominating = true;
-    }
-    p1 = p1->next;
-    p2 = p2->next;
-  }
-  return dominating;
-}
-
-bool dominate(const index::header *header, const value_t *buffer) {
-  size_t n = 0;
-  const index::entry *p = header->tuple;
-  ++index::DT;
-  bool dominating = false;
-  while (p) {
-    if (p->value > buffer[n]) {
-      return false;
-    } else if (p->value < buffer[n] && !dominating) {
-      dominating = true;
-    }
-    ++n;
-    p = p->next;
-  }
-  return dominating;
-}
-
-bool dominate(const value_t *buffer, const index::header *header) {
-  size_t n = 0;
-  const index::entry *p = header->tuple;
-  ++index::DT;
-  bool dominating = false;
-  while (p) {
-    if (buffer[n] > p->value) {
-      return false;
-    } else if (buffer[n] < p->value && !dominating) {
-      dominating = true;
-    }
-    ++n;
-    p = p->next;
-  }
-  return dominating;
-}
-
 size_t index::count() {
   return count_;
 }
@@ -137,19 +95,19 @@ stamp_t index::stamp() {
 #endif
 }
 
-index::index(size_t width) : width_(width) {
-  entry_.header = &header_;
-  construct_();
-}
-
-index::index(value_t *buffer, size_t width, stamp_t window) : buffer_(buffer), width_(width), window_(window) {
+index::index(value_t *buffer, size_t width, stamp_t window)
+    : arena_(slab(window)), buffer_(buffer),
+#ifndef WITH_TIME_WINDOW
+      headers_(window),
+#else
+      headers_(pool_allocator<index::header>(arena_)),
+#endif
+      merge_(index::header::links::allocator_type(arena_)), width_(width), window_(window) {
   entry_.header = &header_;
   construct_();
 }
 
-index::~index() {
-  delete[] indexes_;
-}
+index::~index() = default;
 
 void index::buffer(value_t *buffer) {
   buffer_ = buffer;
@@ -161,42 +119,45 @@ void index::compact() {
   }
   stamp_t stamp = headers_.back().stamp - window_;
   for (auto &&t : headers_.back().tail) {
-    auto &&h = t.first;
-    if (t.second <= stamp) {
-      continue;
-    }
-    if (h->tuple) {
-      auto &&e = h->tuple;
-      size_t d = 0;
-      while (d < width_ && e) {
-        indexes_[d++].erase(*e);
-        e = e->next;
-      }
-      h->tuple = nullptr;
+    if (t.second > stamp && t.first->tuple) {
+      erase_(t.first);
     }
   }
+  prune_(headers_.back().tail);
 }
 
-std::vector<index::header *> &index::expired() {
-  if (headers_.empty()) {
-    return expired_;
-  }
-  expired_.clear();
-  stamp_t stamp = headers_.back().stamp - window_;
-  auto &&h = headers_.begin();
-  while (h != headers_.end() && h->stamp <= stamp) {
-    expired_.push_back(&*h);
-    ++h;
-  }
-  return expired_;
+bool index::dominate(const index::header *h1, const index::header *h2) const {
+  return dominate(h1, h2->tuple);
 }
 
-index::header *index::first() {
-  return &headers_.front();
+bool index::dominate(const index::header *header, const value_t *buffer) const {
+  ++index::DT;
+  return dominance::test(header->tuple, buffer, width_);
+}
+
+bool index::dominate(const value_t *buffer, const index::header *header) const {
+  ++index::DT;
+  return dominance::test(buffer, header->tuple, width_);
 }
 
-std::set<index::entry> &index::get(size_t n) {
-  return indexes_[n];
+index::dimension &index::candidates(size_t n) {
+  settle_();
+  return skylines_[n];
+}
+
+void index::demote(index::header *h) {
+  h->skyline = false;
+  demoted_.push_back(h);
+}
+
+index::span index::expired() {
+  expire_();
+  auto first = headers_.begin();
+  return index::span(first, std::next(first, expired_), expired_);
+}
+
+index::header *index::first() {
+  return &headers_.front();
 }
 
 index::header *index::last() {
@@ -204,10 +165,11 @@ index::header *index::last() {
 }
 
 size_t index::lower() {
+  settle_();
   size_t d = 0;
   double lower = 1;
   for (size_t i = 0; i < width_; ++i) {
-    double e = estimate_(buffer_[i], indexes_[i]);
+    double e = estimate_(buffer_[i], skylines_[i]);
     if (e == 0) {
       return i;
     } else {
@@ -221,12 +183,11 @@ size_t index::lower() {
 }
 
 size_t index::lower(const index::header *h) {
+  settle_();
   size_t d = 0;
   double lower = 1;
-  const index::entry *x = h->tuple;
   for (size_t i = 0; i < width_; ++i) {
-    double e = estimate_(x->value, indexes_[i]);
-    x = x->next;
+    double e = estimate_(h->tuple[i], skylines_[i]);
     if (e == 0) {
       return i;
     } else {
@@ -241,7 +202,7 @@ size_t index::lower(const index::header *h) {
 
 index::entry &index::mute(value_t value) {
   entry_.value = value;
-  header_.stamp = index::stamp() + 1;
+  entry_.stamp = index::stamp() + 1;
   return entry_;
 }
 
@@ -256,37 +217,39 @@ void index::pop() {
   if (headers_.empty()) {
     return;
   }
-  auto &&h = headers_.begin();
-  auto &&e = h->tuple;
-  size_t d = 0;
-  while (d < width_ && e) {
-    indexes_[d++].erase(*e);
-    e = e->next;
+  auto &&h = headers_.front();
+  if (h.tuple) {
+    erase_(&h);
+  }
+  headers_.pop_front();
+  if (expired_) {
+    --expired_;
   }
-  headers_.erase(h);
 }
 
 #else
 
 void index::pop() {
-  if (headers_.empty()) {
-    return;
-  }
-  stamp_t stamp = headers_.back().stamp - window_;
-  auto &&h = headers_.begin();
-  while (h != headers_.end() && h->stamp < stamp) {
-    auto &&e = h->tuple;
-    size_t d = 0;
-    while (d < width_ && e) {
-      indexes_[d++].erase(*e);
-      e = e->next;
+  expire_();
+  for (; expired_; --expired_) {
+    auto &&h = headers_.front();
+    if (h.tuple) {
+      erase_(&h);
     }
-    h = headers_.erase(h);
+    headers_.pop_front();
   }
 }
 
 #endif
 
+void index::promote(index::header *h) {
+  settle_();
+  h->skyline = true;
+  for (size_t n = 0; n < width_; ++n) {
+    skylines_[n].insert(index::entry(h->tuple[n], h->stamp, h));
+  }
+}
+
 index::header *index::put() {
   return put(buffer_);
 }
@@ -302,16 +265,15 @@ index::header *index::put(value_t *buffer) {
 index::header *index::put(value_t *buffer, bool skyline) {
   auto stamp = next_ > 0 ? next_ : index::stamp();
   next_ = 0;
-  headers_.emplace_back(nullptr, skyline, stamp);
+  auto row = static_cast<value_t *>(rows_->get());
+  std::memcpy(row, buffer, sizeof(value_t) * width_);
+  headers_.emplace_back(row, skyline, stamp, index::header::links::allocator_type(arena_));
   auto header = &headers_.back();
-  const index::entry *next = nullptr;
-  size_t n = width_;
-  while (n > 0) {
-    --n;
-    auto &&it = indexes_[n].emplace(header, next, buffer[n]).first;
-    next = &(*it);
+  if (skyline) {
+    for (size_t n = 0; n < width_; ++n) {
+      skylines_[n].insert(index::entry(row[n], stamp, header));
+    }
   }
-  header->tuple = next;
   ++count_; // Important!
   return header;
 }
@@ -321,11 +283,22 @@ size_t index::size() {
 }
 
 void index::tail_append(index::header *sky, index::header *tuple) {
-  sky->tail.emplace_back(tuple, tuple->stamp);
+  auto &&tail = sky->tail;
+  room_(tail);
+  index::header::link link(tuple, tuple->stamp);
+  if (tail.empty() || older(tail.back(), link)) {
+    tail.push_back(link);
+    return;
+  }
+  auto at = std::lower_bound(tail.begin(), tail.end(), link, older);
+  if (at == tail.end() || *at != link) {
+    tail.insert(at, link);
+  }
 }
 
 std::vector<index::header *> &index::tail_get(index::header *sky, stamp_t stamp) {
   tail_.clear();
+  prune_(sky->tail);
   for (auto &&x : sky->tail) {
     if (x.second > stamp) {
       tail_.push_back(x.first);
@@ -335,22 +308,46 @@ std::vector<index::header *> &index::tail_get(index::header *sky, stamp_t stamp)
 }
 
 void index::tail_move(index::header *tuple, index::header *sky) {
-  sky->tail.emplace_back(tuple, tuple->stamp);
-  for (auto &&x : tuple->tail) {
-    sky->tail.emplace_back(x);
-  }
-  tuple->tail.clear();
+  auto &&from = tuple->tail;
+  auto &&to = sky->tail;
+  prune_(from);
+  prune_(to);
+  index::header::link link(tuple, tuple->stamp);
+  from.insert(std::lower_bound(from.begin(), from.end(), link, older), link);
+  merge_.clear();
+  std::set_union(to.begin(), to.end(), from.begin(), from.end(), std::back_inserter(merge_), older);
+  to.swap(merge_);
+  from.clear();
 }
 
 void index::tail_remove(index::header *sky) {
   sky->tail.clear();
 }
 
+size_t index::tail_live() {
+  size_t n = 0;
+  for (auto &&h : headers_) {
+    for (auto &&x : h.tail) {
+      n += x.second >= headers_.front().stamp && x.first->tuple;
+    }
+  }
+  return n;
+}
+
+size_t index::tail_total() {
+  size_t n = 0;
+  for (auto &&h : headers_) {
+    n += h.tail.size();
+  }
+  return n;
+}
+
 size_t index::upper() {
+  settle_();
   size_t d = 0;
   double upper = 0;
   for (size_t i = 0; i < width_; ++i) {
-    double e = estimate_(buffer_[i], indexes_[i]);
+    double e = estimate_(buffer_[i], skylines_[i]);
     if (e == 1) {
       return i;
     } else {
@@ -364,12 +361,11 @@ size_t index::upper() {
 }
 
 size_t index::upper(const index::header *h) {
+  settle_();
   size_t d = 0;
   double upper = 0;
-  const index::entry *x = h->tuple;
   for (size_t i = 0; i < width_; ++i) {
-    double e = estimate_(x->value, indexes_[i]);
-    x = x->next;
+    double e = estimate_(h->tuple[i], skylines_[i]);
     if (e == 1) {
       return i;
     } else {
@@ -382,26 +378,80 @@ size_t index::upper(const index::header *h) {
   return d;
 }
 
-double index::estimate_(const value_t &v, const std::set<index::entry> &d) {
+// The share of a dimension with values less than a value.
+double index::estimate_(const value_t &v, const index::dimension &d) {
   if (d.empty()) {
     return 0;
   }
-  auto &&first = d.begin()->value;
-  auto &&last = d.rbegin()->value;
-  if (first == last) {
-    return 1;
+  return 1.0 * d.rank(index::entry(v, 0, nullptr)) / d.size();
+}
+
+// Remove a tuple from the skyline dimensional indexes and release its
+// values.
+void index::erase_(index::header *h) {
+  settle_();
+  if (h->skyline) {
+    for (size_t n = 0; n < width_; ++n) {
+      skylines_[n].erase(index::entry(h->tuple[n], h->stamp, h));
+    }
   }
-  if (v < first) {
-    return 0;
+  rows_->put(h->tuple);
+  h->tuple = nullptr;
+}
+
+// Drop links to expired tuples, a prefix, and to tuples removed by
+// compact(), which are dominated by the latest tuple and cannot be promoted.
+void index::prune_(index::header::links &tail) {
+  if (tail.empty()) {
+    return;
   }
-  if (last < v) {
-    return 1;
+  stamp_t first = headers_.front().stamp;
+  auto live = std::lower_bound(tail.begin(), tail.end(), index::header::link(nullptr, first), older);
+  tail.erase(std::remove_if(live, tail.end(), [](const index::header::link &x) {
+    return !x.first->tuple;
+  }), tail.end());
+  tail.erase(tail.begin(), live);
+}
+
+// Prune a full tail before it grows, and grow it only when more than half
+// of it is live, so that appending stays amortized constant time.
+void index::room_(index::header::links &tail) {
+  if (tail.size() == tail.capacity()) {
+    prune_(tail);
+    if (2 * tail.size() > tail.capacity()) {
+      tail.reserve(2 * tail.capacity());
+    }
+  }
+}
+
+// Remove the demoted tuples from the skyline dimensional indexes, which is
+// deferred since erasing invalidates the iterators of a running scan.
+void index::settle_() {
+  for (auto &&h : demoted_) {
+    for (size_t n = 0; n < width_; ++n) {
+      skylines_[n].erase(index::entry(h->tuple[n], h->stamp, h));
+    }
+  }
+  demoted_.clear();
+}
+
+// Move the expiry cursor past the tuples that expired since the last call.
+void index::expire_() {
+  if (headers_.empty()) {
+    return;
+  }
+  stamp_t last = headers_.back().stamp;
+  while (expired_ < headers_.size() && headers_[expired_].stamp + window_ <= last) {
+    ++expired_;
   }
-  return 1.0 * std::abs(v - first) / std::abs(last - first);
 }
 
 void index::construct_() {
-  indexes_ = new std::set<index::entry>[width_];
+  skylines_.reserve(width_);
+  for (size_t i = 0; i < width_; ++i) {
+    skylines_.emplace_back(pool_allocator<index::entry>(arena_));
+  }
+  rows_ = &arena_.get(sizeof(value_t) * width_);
   struct timeval t{};
   gettimeofday(&t, (struct timezone *) nullptr);
   zero_ = t.tv_sec;
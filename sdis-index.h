@@ -30,10 +30,13 @@
 #define SDIS_INDEX_H
 
 #include <iostream>
-#include <list>
-#include <set>
+#include <deque>
+#include <iterator>
 #include <vector>
 #include <unordered_set>
+#include "sdis-btree.h"
+#include "sdis-pool.h"
+#include "sdis-ring.h"
 #include "types.h"
 
 namespace sdistream {
@@ -42,12 +45,13 @@ class index;
 struct index_entry;
 struct index_header;
 
+// A key of a dimensional index, ordered by value then by stamp.
 struct index_entry {
-  index_header *header = nullptr;
-  const index_entry *next = nullptr;
   value_t value = 0;
+  stamp_t stamp = 0;
+  index_header *header = nullptr;
   index_entry() = default;
-  index_entry(index_header *h, const index_entry *n, value_t v) : header(h), next(n), value(v) {
+  index_entry(value_t v, stamp_t s, index_header *h) : value(v), stamp(s), header(h) {
   }
 };
 
@@ -55,23 +59,22 @@ bool operator==(const index_entry &, const index_entry &);
 bool operator<(const index_entry &, const index_entry &);
 
 struct index_header {
+  typedef std::pair<index_header *, stamp_t> link;
+  typedef std::vector<link, pool_allocator<link>> links;
   bool skyline = false;
   stamp_t stamp = 0;
-  std::vector<std::pair<index_header *, stamp_t>> tail;
-  const index_entry *tuple = nullptr;
+  // Dominated tuples with their stamps, which tell expired tuples whose
+  // headers may have been reused. Sorted by stamp without duplicates, and
+  // pruned of expired and compacted tuples when read, merged or grown.
+  links tail;
+  // The values of the tuple, nullptr once compact() released them.
+  value_t *tuple = nullptr;
   index_header() = default;
-  index_header(const index_entry *h, bool k, stamp_t s) : tuple(h), skyline(k), stamp(s) {
+  index_header(value_t *t, bool k, stamp_t s, const links::allocator_type &a)
+      : skyline(k), stamp(s), tail(a), tuple(t) {
   }
-  value_t value(size_t n) {
-    size_t p = 0;
-    const index_entry *e = tuple;
-    while (e) {
-      if (p++ == n) {
-        return e->value;
-      }
-      e = e->next;
-    }
-    return 0;
+  value_t value(size_t n) const {
+    return tuple[n];
   }
 };
 
@@ -82,25 +85,65 @@ class index {
 public:
   typedef index_entry entry;
   typedef index_header header;
-  typedef std::set<index_entry>::iterator iterator;
-  typedef std::set<index_entry>::reverse_iterator reverse_iterator;
+  typedef btree<index_entry, pool_allocator<index_entry>> dimension;
+  typedef dimension::iterator iterator;
+  typedef dimension::reverse_iterator reverse_iterator;
+#ifndef WITH_TIME_WINDOW
+  // Headers of a count window expire in arrival order, the engines pop the
+  // first one before putting a tuple into a full window.
+  typedef ring<index::header> headers;
+#else
+  typedef std::deque<index::header, pool_allocator<index::header>> headers;
+#endif
+  // Headers from the first one.
+  class span {
+  public:
+    span(headers::iterator first, headers::iterator last, size_t n) : first_(first), last_(last), size_(n) {
+    }
+    auto begin() const -> headers::iterator {
+      return first_;
+    }
+    auto end() const -> headers::iterator {
+      return last_;
+    }
+    auto back() const -> index::header & {
+      return *std::prev(last_);
+    }
+    auto empty() const -> bool {
+      return size_ == 0;
+    }
+    auto size() const -> size_t {
+      return size_;
+    }
+  private:
+    headers::iterator first_;
+    headers::iterator last_;
+    size_t size_;
+  };
   static size_t DT;
   static size_t count();
   static bool &skyline(const index::entry *);
   static stamp_t stamp();
-  explicit index(size_t);
   index(value_t *, size_t, stamp_t);
   virtual ~index();
   // Put a tuple to index buffer.
   void buffer(value_t *);
-  // Compact dimension index.
+  // Release the values of the tuples dominated by the latest tuple.
   void compact();
-  // Return all expired tuples.
-  std::vector<index::header *> &expired();
+  // The first tuple dominates the second tuple.
+  bool dominate(const index::header *, const index::header *) const;
+  bool dominate(const index::header *, const value_t *) const;
+  bool dominate(const value_t *, const index::header *) const;
+  // Return the expired tuples, found by a cursor that passes each tuple
+  // once.
+  span expired();
+  // Return a dimensional index of the skyline tuples.
+  dimension &candidates(size_t);
+  // Remove a tuple from the skyline, and from the skyline dimensional indexes
+  // once the scans that found it are over.
+  void demote(index::header *);
   // Return the first stamp.
   index::header *first();
-  // Return an dimensional index.
-  std::set<index::entry> &get(size_t);
   // Return the last stamp.
   index::header *last();
   // Return the lower bound dimensional index of the buffered tuple.
@@ -111,8 +154,11 @@ public:
   index::entry &mute(value_t);
   // Pre-fetch the next stamp.
   stamp_t next();
-  // Pop expired tuples.
+  // Pop the first tuple of a count window, the expired tuples of a time
+  // window.
   void pop();
+  // Add a tuple to the skyline.
+  void promote(index::header *);
   // Put the buffered tuple into the index.
   index::header *put();
   // Put the buffered tuple into the index with skyline flag.
@@ -131,34 +177,42 @@ public:
   void tail_move(index::header *, index::header *);
   // Remove a skyline tuple.
   void tail_remove(index::header *);
+  // The number of links to unexpired and uncompacted tuples in all tails.
+  size_t tail_live();
+  // The number of links in all tails.
+  size_t tail_total();
   // Return the upper bound dimensional index of the buffered tuple.
   size_t upper();
   // Return the upper bound dimensional index of an indexed tuple.
   size_t upper(const index::header *);
 private:
-  static double estimate_(const value_t &, const std::set<index::entry> &);
+  static double estimate_(const value_t &, const dimension &);
   static size_t count_;
   static size_t zero_;
   void construct_();
+  void erase_(index::header *);
+  void expire_();
+  void prune_(index::header::links &);
+  void room_(index::header::links &);
+  void settle_();
+  // Index entries, headers, rows and tails, declared first to be destroyed
+  // last.
+  arena arena_;
   value_t *buffer_ = nullptr;
   index_entry entry_;
-  std::vector<index::header *> expired_;
+  size_t expired_ = 0; // Headers before the expiry cursor.
   index::header header_;
-  std::list<index::header> headers_;
-  std::set<index::entry> *indexes_ = nullptr;
+  index::headers headers_;
+  std::vector<dimension> skylines_; // Dimensional indexes of the skyline tuples.
+  std::vector<index::header *> demoted_; // Skyline tuples to remove from skylines_.
+  pool *rows_ = nullptr;
   stamp_t next_ = 0;
   std::vector<index::header *> tail_;
+  index::header::links merge_;
   size_t width_ = 0;
   stamp_t window_ = 0;
 };
 
-bool dominate(const index::entry *, const index::entry *);
-bool dominate(const index::entry *, const value_t *);
-bool dominate(const value_t *, const index::entry *);
-bool dominate(const index::header *, const index::header *);
-bool dominate(const index::header *, const value_t *);
-bool dominate(const value_t *, const index::header *);
-
 }
 
 #endif //SDIS_INDEX_H
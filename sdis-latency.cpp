@@ -0,0 +1,93 @@
+/*-
+ * Copyright (c) 2019 Rui Liu and Dominique Li <dominique.li@univ-tours.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id: log.h 998 2014-12-18 12:07:14Z li $
+ */
+
+#include <cmath>
+#include <sstream>
+#include "sdis-latency.h"
+
+namespace sdistream {
+
+const char *latency::NAMES[latency::KINDS] = {"insert", "dominated", "expiry"};
+size_t latency::period = 0;
+
+auto histogram::count() const -> uint64_t {
+  return count_;
+}
+
+auto histogram::max() const -> uint64_t {
+  return max_;
+}
+
+auto histogram::mean() const -> double {
+  return count_ ? sum_ / count_ : 0;
+}
+
+auto histogram::percentile(double q) const -> uint64_t {
+  if (!count_) {
+    return 0;
+  }
+  auto rank = (uint64_t) std::ceil(q * count_);
+  if (rank < 1) {
+    rank = 1;
+  }
+  uint64_t seen = 0;
+  for (size_t i = 0; i < BUCKETS; ++i) {
+    seen += buckets_[i];
+    if (seen >= rank) {
+      auto v = upper_(i);
+      return v < max_ ? v : max_;
+    }
+  }
+  return max_;
+}
+
+auto histogram::upper_(size_t n) -> uint64_t {
+  if (n < 2 * SUB) {
+    return n;
+  }
+  size_t shift = n / SUB - 1;
+  uint64_t mantissa = n % SUB + SUB;
+  return ((mantissa + 1) << shift) - 1;
+}
+
+static void report(sink &out, const char *name, const histogram &h) {
+  std::ostringstream line;
+  line << "# Latency (ns) " << name << ": n=" << h.count() << " mean=" << (uint64_t) h.mean() << " p50="
+       << h.percentile(0.5) << " p90=" << h.percentile(0.9) << " p99=" << h.percentile(0.99) << " p99.9="
+       << h.percentile(0.999) << " max=" << h.max();
+  out.comment(line.str());
+}
+
+void latency::report(sink &out) const {
+  sdistream::report(out, "all", all_);
+  for (size_t k = 0; k < KINDS; ++k) {
+    sdistream::report(out, NAMES[k], histograms_[k]);
+  }
+}
+
+}
@@ -0,0 +1,112 @@
+/*-
+ * Copyright (c) 2019 Rui Liu and Dominique Li <dominique.li@univ-tours.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id: log.h 998 2014-12-18 12:07:14Z li $
+ */
+
+#ifndef SDIS_LATENCY_H
+#define SDIS_LATENCY_H
+
+#ifndef HISTOGRAM_BITS
+#define HISTOGRAM_BITS 5
+#endif
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include "sdis-sink.h"
+
+namespace sdistream {
+
+// A log-bucketed histogram of nanosecond values. Each power of two is
+// split into 2^HISTOGRAM_BITS buckets, giving a relative error below
+// 2^-HISTOGRAM_BITS at constant memory.
+class histogram {
+public:
+  static const size_t SUB = size_t(1) << HISTOGRAM_BITS;
+  static const size_t BUCKETS = (65 - HISTOGRAM_BITS) * SUB;
+  histogram() = default;
+  // The number of recorded values.
+  auto count() const -> uint64_t;
+  // The largest recorded value.
+  auto max() const -> uint64_t;
+  // The mean of recorded values.
+  auto mean() const -> double;
+  // The value at a quantile in [0, 1], as the upper bound of its bucket.
+  auto percentile(double) const -> uint64_t;
+  // Record a value.
+  inline void put(uint64_t v) {
+    ++buckets_[bucket_(v)];
+    ++count_;
+    sum_ += v;
+    if (v > max_) {
+      max_ = v;
+    }
+  }
+private:
+  static inline auto bucket_(uint64_t v) -> size_t {
+    if (v < 2 * SUB) {
+      return v;
+    }
+    size_t shift = 63 - __builtin_clzll(v) - HISTOGRAM_BITS;
+    return shift * SUB + (v >> shift);
+  }
+  static auto upper_(size_t) -> uint64_t;
+  std::array<uint64_t, BUCKETS> buckets_{};
+  uint64_t count_ = 0;
+  uint64_t max_ = 0;
+  double sum_ = 0;
+};
+
+// Per-tuple latencies, split by the kind of work done for a tuple.
+class latency {
+public:
+  enum kind {
+    INSERT, // The tuple entered the skyline.
+    DOMINATED, // The tuple was dominated.
+    EXPIRY, // The tuple expired a skyline tuple.
+    KINDS
+  };
+  static const char *NAMES[KINDS];
+  // Report every period recorded tuples, 0 to report at the end only.
+  static size_t period;
+  latency() = default;
+  // Record the latency of a tuple, return true if a report is due.
+  inline auto put(kind k, uint64_t ns) -> bool {
+    histograms_[k].put(ns);
+    all_.put(ns);
+    return period && ++count_ % period == 0;
+  }
+  // Write percentiles of all tuples and of each kind to a sink.
+  void report(sink &) const;
+private:
+  std::array<histogram, KINDS> histograms_;
+  histogram all_;
+  size_t count_ = 0;
+};
+
+}
+
+#endif //SDIS_LATENCY_H
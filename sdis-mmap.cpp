@@ -0,0 +1,335 @@
+/*-
+ * Copyright (c) 2019 Rui Liu and Dominique Li <dominique.li@univ-tours.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id: log.h 998 2014-12-18 12:07:14Z li $
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#if defined(WITH_SIMD_SCAN) && defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include "sdis-mmap.h"
+#include "timer.h"
+
+namespace sdistream {
+
+// Powers of ten that are exact in double precision.
+static const double POW10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Find the end of the current token.
+static auto token_(const char *p, const char *last) -> const char * {
+  while (p < last && *p != ',' && *p != ' ' && *p != '\0') {
+    ++p;
+  }
+  return p;
+}
+
+// Find the end of the current line.
+static auto newline_(const char *p, const char *last) -> const char * {
+#if defined(WITH_SIMD_SCAN) && defined(__SSE2__)
+  auto nl = _mm_set1_epi8('\n');
+  while (p + 16 <= last) {
+    auto mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) p), nl));
+    if (mask) {
+      return p + __builtin_ctz(mask);
+    }
+    p += 16;
+  }
+#endif
+  return (const char *) memchr(p, '\n', last - p);
+}
+
+// Convert a token with strtod(), the token is not NUL-terminated.
+static auto strtod_(const char *first, const char *last) -> value_t {
+  char local[64];
+  size_t n = last - first;
+  if (n < sizeof(local)) {
+    memcpy(local, first, n);
+    local[n] = '\0';
+    return strtod(local, nullptr);
+  }
+  std::string token(first, last);
+  return strtod(token.c_str(), nullptr);
+}
+
+mapped::~mapped() {
+  close();
+}
+
+auto mapped::open(const char *path) -> bool {
+  close();
+  int fd = ::open(path, O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st{};
+  if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode)) {
+    ::close(fd);
+    return false;
+  }
+  if (st.st_size > 0) {
+    void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) {
+      ::close(fd);
+      return false;
+    }
+    madvise(p, st.st_size, MADV_SEQUENTIAL);
+    data_ = (const char *) p;
+    size_ = st.st_size;
+  }
+  ::close(fd);
+  return true;
+}
+
+void mapped::close() {
+  if (data_) {
+    munmap((void *) data_, size_);
+  }
+  data_ = nullptr;
+  size_ = 0;
+}
+
+auto mapped::data() const -> const char * {
+  return data_;
+}
+
+auto mapped::size() const -> size_t {
+  return size_;
+}
+
+auto csv_stream::open(const char *path) -> bool {
+  if (!mapped::open(path)) {
+    return false;
+  }
+  cursor_ = data_;
+  return true;
+}
+
+auto csv_stream::read(size_t width, value_t *buffer) -> bool {
+  auto last = data_ + size_;
+  if (cursor_ >= last) {
+    return false;
+  }
+  // As std::istream::getline(), a last line without line feed is dropped.
+  auto eol = newline_(cursor_, last);
+  if (!eol) {
+    cursor_ = last;
+    return false;
+  }
+  // Same tokens as strtok() with ", " delimiters.
+  auto p = cursor_;
+  size_t n = 0;
+  while (n < width) {
+    while (p < eol && (*p == ',' || *p == ' ')) {
+      ++p;
+    }
+    if (p == eol || *p == '\0') {
+      break;
+    }
+    p = parse(p, eol, buffer[n]);
+    ++n;
+    if (p < eol && *p == '\0') {
+      break;
+    }
+  }
+  cursor_ = eol + 1;
+  return true;
+}
+
+auto binary_stream::open(const char *path) -> bool {
+  if (!mapped::open(path)) {
+    return false;
+  }
+  binary_header header;
+  binary_header expected;
+  if (size_ < sizeof(header)) {
+    close();
+    return false;
+  }
+  memcpy(&header, data_, sizeof(header));
+  if (memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 || header.version != expected.version
+      || header.width == 0) {
+    close();
+    return false;
+  }
+  timed_ = (header.flags & binary_header::TIMESTAMP) != 0;
+  width_ = header.width;
+  stride_ = width_ + (timed_ ? 1 : 0);
+  // Trust the file size rather than the header for truncated streams.
+  size_t available = (size_ - sizeof(header)) / (sizeof(value_t) * stride_);
+  count_ = header.count && header.count < available ? header.count : available;
+  rows_ = (const value_t *) (data_ + sizeof(header));
+  next_ = 0;
+  stamp_ = 0;
+  return true;
+}
+
+auto binary_stream::count() const -> size_t {
+  return count_;
+}
+
+auto binary_stream::next() -> const value_t * {
+  if (next_ >= count_) {
+    return nullptr;
+  }
+  auto row = rows_ + next_ * stride_;
+  if (timed_) {
+    stamp_ = *row++;
+    if (pace_ && next_ == 0) {
+      first_ = stamp_;
+      start_ = timer::microtime();
+    } else if (pace_) {
+      // Sleep through long gaps, then spin until the tuple is due.
+      double due = start_ + (stamp_ - first_);
+      double wait = due - timer::microtime();
+      if (wait > 0.002) {
+        usleep((useconds_t) ((wait - 0.001) * 1000000));
+      }
+      while (timer::microtime() < due) {
+      }
+    }
+  }
+  ++next_;
+  return row;
+}
+
+void binary_stream::pace(bool pace) {
+  pace_ = pace;
+}
+
+auto binary_stream::read(size_t width, value_t *buffer) -> bool {
+  auto row = next();
+  if (!row) {
+    return false;
+  }
+  std::memcpy(buffer, row, sizeof(value_t) * (width < width_ ? width : width_));
+  return true;
+}
+
+auto binary_stream::stamp() const -> double {
+  return stamp_;
+}
+
+auto binary_stream::timed() const -> bool {
+  return timed_;
+}
+
+auto binary_stream::width() const -> size_t {
+  return width_;
+}
+
+auto parse(const char *first, const char *last, value_t &value) -> const char * {
+  auto p = first;
+  bool negative = false;
+  if (p < last && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    ++p;
+  }
+  uint64_t mantissa = 0;
+  int digits = 0; // Significant digits.
+  int exponent = 0;
+  bool any = false;
+  while (p < last && *p >= '0' && *p <= '9') {
+    any = true;
+    if (mantissa || *p != '0') {
+      mantissa = mantissa * 10 + (*p - '0');
+      ++digits;
+    }
+    ++p;
+    if (digits > 19) {
+      break;
+    }
+  }
+  if (p < last && *p == '.' && digits <= 19) {
+    ++p;
+    while (p < last && *p >= '0' && *p <= '9') {
+      any = true;
+      if (mantissa || *p != '0') {
+        mantissa = mantissa * 10 + (*p - '0');
+        ++digits;
+      }
+      --exponent;
+      ++p;
+      if (digits > 19) {
+        break;
+      }
+    }
+  }
+  if (any && p < last && (*p == 'e' || *p == 'E')) {
+    auto q = p + 1;
+    bool minus = false;
+    if (q < last && (*q == '-' || *q == '+')) {
+      minus = *q == '-';
+      ++q;
+    }
+    if (q < last && *q >= '0' && *q <= '9') {
+      int e = 0;
+      while (q < last && *q >= '0' && *q <= '9') {
+        if (e < 10000) {
+          e = e * 10 + (*q - '0');
+        }
+        ++q;
+      }
+      exponent += minus ? -e : e;
+      p = q;
+    }
+  }
+  // Only decimal numbers that end with the token and can be converted
+  // exactly with a single rounding are parsed here (Clinger's fast path),
+  // anything else falls back to strtod().
+  bool fast = any && digits <= 19 && (p == last || *p == ',' || *p == ' ' || *p == '\r' || *p == '\0');
+  if (fast && mantissa == 0) {
+    value = negative ? -0.0 : 0.0;
+  } else if (fast && mantissa <= (uint64_t(1) << 53) && exponent >= -22 && exponent <= 22) {
+    double v = (double) mantissa;
+    v = exponent < 0 ? v / POW10[-exponent] : v * POW10[exponent];
+    value = negative ? -v : v;
+  } else {
+    auto end = token_(first, last);
+    value = strtod_(first, end);
+    return end;
+  }
+  return token_(p, last);
+}
+
+auto input(csv_stream &in, size_t width, value_t *buffer) -> bool {
+  return in.read(width, buffer);
+}
+
+auto input(binary_stream &in, size_t width, value_t *buffer) -> bool {
+  return in.read(width, buffer);
+}
+
+}
@@ -0,0 +1,123 @@
+/*-
+ * Copyright (c) 2019 Rui Liu and Dominique Li <dominique.li@univ-tours.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id: log.h 998 2014-12-18 12:07:14Z li $
+ */
+
+#ifndef SDIS_MMAP_H
+#define SDIS_MMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include "types.h"
+
+namespace sdistream {
+
+// A read-only memory-mapped file.
+class mapped {
+public:
+  mapped() = default;
+  mapped(const mapped &) = delete;
+  auto operator=(const mapped &) -> mapped & = delete;
+  virtual ~mapped();
+  // Map a file into memory, return false if it cannot be mapped.
+  auto open(const char *) -> bool;
+  // Unmap the file.
+  void close();
+  // The first byte of the mapped file.
+  auto data() const -> const char *;
+  // The size of the mapped file in bytes.
+  auto size() const -> size_t;
+protected:
+  const char *data_ = nullptr;
+  size_t size_ = 0;
+};
+
+// A CSV stream parsed in place from a memory-mapped file. Each line is
+// parsed exactly as input() does for an std::istream, except that lines
+// are not limited to BUFFER characters.
+class csv_stream : public mapped {
+public:
+  csv_stream() = default;
+  auto open(const char *) -> bool;
+  // Parse the next line into a tuple buffer.
+  auto read(size_t, value_t *) -> bool;
+private:
+  const char *cursor_ = nullptr;
+};
+
+// Header of a binary stream. It is followed by packed rows of value_t in
+// native byte order, each row being prefixed by a timestamp if required.
+struct binary_header {
+  static const uint32_t TIMESTAMP = 1;
+  char magic[4] = {'S', 'D', 'I', 'S'};
+  uint32_t version = 1;
+  uint32_t width = 0;
+  uint32_t flags = 0;
+  uint64_t count = 0; // Zero if unknown.
+  uint64_t reserved = 0;
+};
+
+// A binary stream read from a memory-mapped file without any parsing.
+class binary_stream : public mapped {
+public:
+  binary_stream() = default;
+  auto open(const char *) -> bool;
+  // The number of tuples in the stream.
+  auto count() const -> size_t;
+  // Return the next tuple in the mapped region, or nullptr at the end.
+  auto next() -> const value_t *;
+  // Replay tuples at their recorded timestamps.
+  void pace(bool);
+  // Copy the next tuple into a tuple buffer.
+  auto read(size_t, value_t *) -> bool;
+  // The timestamp of the last returned tuple, zero if not recorded.
+  auto stamp() const -> double;
+  // Whether tuples are recorded with timestamps.
+  auto timed() const -> bool;
+  // The dimensionality of the stream.
+  auto width() const -> size_t;
+private:
+  size_t count_ = 0;
+  double first_ = 0;
+  size_t next_ = 0;
+  bool pace_ = false;
+  const value_t *rows_ = nullptr;
+  double stamp_ = 0;
+  double start_ = 0;
+  size_t stride_ = 0;
+  bool timed_ = false;
+  size_t width_ = 0;
+};
+
+// Parse a number from a token, return the end of the token.
+auto parse(const char *, const char *, value_t &) -> const char *;
+
+auto input(csv_stream &, size_t, value_t *) -> bool;
+auto input(binary_stream &, size_t, value_t *) -> bool;
+
+}
+
+#endif //SDIS_MMAP_H
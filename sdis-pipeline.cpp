@@ -0,0 +1,101 @@
+/*-
+ * Copyright (c) 2019 Rui Liu and Dominique Li <dominique.li@univ-tours.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id: log.h 998 2014-12-18 12:07:14Z li $
+ */
+
+#include "sdis-pipeline.h"
+
+namespace sdistream {
+
+pipeline::pipeline(size_t width, size_t depth) : depth_(depth ? depth : 1), ring_(depth ? depth : 1), width_(width) {
+  for (auto &&b : ring_) {
+    b.tuples.resize(width_ * PIPELINE_BLOCK);
+  }
+}
+
+pipeline::~pipeline() {
+  stop();
+}
+
+auto pipeline::blocks() const -> size_t {
+  return tail_.load(std::memory_order_relaxed);
+}
+
+auto pipeline::consumer_stalls() const -> size_t {
+  return consumer_stalls_;
+}
+
+auto pipeline::producer_stalls() const -> size_t {
+  return producer_stalls_;
+}
+
+auto pipeline::read(size_t width, value_t *buffer) -> bool {
+  size_t tail = tail_.load(std::memory_order_relaxed);
+  bool stalled = false;
+  while (true) {
+    auto &&b = ring_[tail % depth_];
+    if (cursor_ < b.count.load(std::memory_order_acquire)) {
+      std::memcpy(buffer, &b.tuples[cursor_ * width_], sizeof(value_t) * (width < width_ ? width : width_));
+      ++cursor_;
+      return true;
+    }
+    // The reader has moved on, release the block. The count is reset here
+    // so that the reader never sees a stale count when reusing the block.
+    if (head_.load(std::memory_order_acquire) != tail) {
+      if (cursor_ < b.count.load(std::memory_order_acquire)) {
+        continue;
+      }
+      b.count.store(0, std::memory_order_relaxed);
+      cursor_ = 0;
+      tail_.store(++tail, std::memory_order_release);
+      continue;
+    }
+    if (done_.load(std::memory_order_acquire)) {
+      if (cursor_ < b.count.load(std::memory_order_acquire) || head_.load(std::memory_order_acquire) != tail) {
+        continue;
+      }
+      return false;
+    }
+    if (!stalled) {
+      stalled = true;
+      ++consumer_stalls_;
+    }
+    std::this_thread::yield();
+  }
+}
+
+void pipeline::stop() {
+  if (thread_.joinable()) {
+    stop_ = true;
+    thread_.join();
+  }
+}
+
+auto input(pipeline &in, size_t width, value_t *buffer) -> bool {
+  return in.read(width, buffer);
+}
+
+}
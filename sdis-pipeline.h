@@ -0,0 +1,132 @@
+/*-
+ * Copyright (c) 2019 Rui Liu and Dominique Li <dominique.li@univ-tours.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id: log.h 998 2014-12-18 12:07:14Z li $
+ */
+
+#ifndef SDIS_PIPELINE_H
+#define SDIS_PIPELINE_H
+
+#ifndef PIPELINE_BLOCK
+#define PIPELINE_BLOCK 256
+#endif
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "sdis-stream.h"
+#include "types.h"
+
+namespace sdistream {
+
+// A reader thread parsing a stream into a single-producer/single-consumer
+// ring of tuple blocks. Tuples are published one by one, so that the
+// engine never waits for a block to be filled.
+class pipeline {
+public:
+  pipeline(size_t, size_t);
+  pipeline(const pipeline &) = delete;
+  auto operator=(const pipeline &) -> pipeline & = delete;
+  virtual ~pipeline();
+  // The number of blocks handed over to the engine.
+  auto blocks() const -> size_t;
+  // The number of times the engine waited for the reader (ring empty).
+  auto consumer_stalls() const -> size_t;
+  // The number of times the reader waited for the engine (ring full).
+  auto producer_stalls() const -> size_t;
+  // Take the next tuple from the ring, return false at the end of stream.
+  auto read(size_t, value_t *) -> bool;
+  // Start the reader thread on a stream.
+  template<class IN>
+  void start(IN &);
+  // Stop the reader thread.
+  void stop();
+private:
+  struct block {
+    std::atomic<size_t> count{0};
+    std::vector<value_t> tuples;
+  };
+  template<class IN>
+  void produce_(IN &);
+  size_t depth_ = 0;
+  std::vector<block> ring_;
+  std::thread thread_;
+  size_t width_ = 0;
+  // Reader side.
+  alignas(64) std::atomic<size_t> head_{0};
+  std::atomic<bool> done_{false};
+  std::atomic<bool> stop_{false};
+  size_t producer_stalls_ = 0;
+  // Engine side.
+  alignas(64) std::atomic<size_t> tail_{0};
+  size_t consumer_stalls_ = 0;
+  size_t cursor_ = 0;
+};
+
+template<class IN>
+void pipeline::start(IN &in) {
+  stop();
+  stop_ = false;
+  thread_ = std::thread([this, &in]() {
+    produce_(in);
+  });
+}
+
+template<class IN>
+void pipeline::produce_(IN &in) {
+  std::vector<value_t> tuple(width_, 0); // Parse buffer, kept across tuples as by input().
+  size_t head = head_.load(std::memory_order_relaxed);
+  bool more = true;
+  while (more && !stop_.load(std::memory_order_relaxed)) {
+    // Wait for the engine to release a block.
+    if (head - tail_.load(std::memory_order_acquire) >= depth_) {
+      ++producer_stalls_;
+      while (head - tail_.load(std::memory_order_acquire) >= depth_) {
+        if (stop_.load(std::memory_order_relaxed)) {
+          done_.store(true, std::memory_order_release);
+          return;
+        }
+        std::this_thread::yield();
+      }
+    }
+    auto &&b = ring_[head % depth_];
+    size_t n = 0;
+    while (n < PIPELINE_BLOCK && (more = input(in, width_, tuple.data()))) {
+      std::memcpy(&b.tuples[n * width_], tuple.data(), sizeof(value_t) * width_);
+      b.count.store(++n, std::memory_order_release);
+    }
+    if (n > 0) {
+      head_.store(++head, std::memory_order_release);
+    }
+  }
+  done_.store(true, std::memory_order_release);
+}
+
+auto input(pipeline &, size_t, value_t *) -> bool;
+
+}
+
+#endif //SDIS_PIPELINE_H
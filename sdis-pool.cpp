@@ -0,0 +1,98 @@
+/*-
+ * Copyright (c) 2019 Rui Liu and Dominique Li <dominique.li@univ-tours.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id: log.h 998 2014-12-18 12:07:14Z li $
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include "sdis-pool.h"
+
+namespace sdistream {
+
+size_t arena::ALLOCATIONS = 0;
+
+pool::pool(size_t size, size_t slab) : size_(size), slab_(slab) {
+}
+
+pool::~pool() {
+  for (auto &&s : slabs_) {
+    ::operator delete(s);
+  }
+}
+
+auto pool::size() const -> size_t {
+  return size_;
+}
+
+auto pool::grow_() -> void * {
+  if (next_ == end_) {
+    // Large blocks come in smaller slabs.
+    auto slab = std::max<size_t>(1, std::min<size_t>(slab_, POOL_SLAB_BYTES / size_));
+    next_ = static_cast<char *>(::operator new(size_ * slab));
+    end_ = next_ + size_ * slab;
+    slabs_.push_back(next_);
+    ++arena::ALLOCATIONS;
+  }
+  auto block = next_;
+  next_ += size_;
+  return block;
+}
+
+arena::arena(size_t slab) : slab_(slab > 0 ? slab : 1) {
+}
+
+arena::~arena() {
+  for (auto &&p : pools_) {
+    delete p;
+  }
+}
+
+auto arena::get(size_t size) -> pool & {
+  // Blocks hold a free list link and keep the alignment of operator new.
+  const size_t align = alignof(std::max_align_t);
+  size = size < sizeof(void *) ? sizeof(void *) : size;
+  size = (size + align - 1) / align * align;
+  for (auto &&p : pools_) {
+    if (p->size() == size) {
+      return *p;
+    }
+  }
+  pools_.push_back(new pool(size, slab_));
+  return *pools_.back();
+}
+
+auto arena::array(size_t size) -> pool * {
+  if (size > POOL_ARRAY) {
+    return nullptr;
+  }
+  size_t block = sizeof(void *);
+  while (block < size) {
+    block *= 2;
+  }
+  return &get(block);
+}
+
+}
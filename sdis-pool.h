@@ -0,0 +1,148 @@
+/*-
+ * Copyright (c) 2019 Rui Liu and Dominique Li <dominique.li@univ-tours.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id: log.h 998 2014-12-18 12:07:14Z li $
+ */
+
+#ifndef SDIS_POOL_H
+#define SDIS_POOL_H
+
+#ifndef POOL_SLAB
+#define POOL_SLAB 4096
+#endif
+
+#ifndef POOL_SLAB_BYTES
+#define POOL_SLAB_BYTES (16 << 20)
+#endif
+
+#ifndef POOL_ARRAY
+#define POOL_ARRAY (64 << 10)
+#endif
+
+#include <cstddef>
+#include <vector>
+
+namespace sdistream {
+
+// Blocks of one size carved from slabs of blocks. Freed blocks are kept on
+// a free list, so that a steady number of live blocks needs no system
+// allocation.
+class pool {
+public:
+  pool(size_t, size_t);
+  pool(const pool &) = delete;
+  auto operator=(const pool &) -> pool & = delete;
+  virtual ~pool();
+  // Get a block.
+  inline auto get() -> void * {
+    if (!free_) {
+      return grow_();
+    }
+    auto block = free_;
+    free_ = *static_cast<void **>(block);
+    return block;
+  }
+  // Put a block back.
+  inline void put(void *block) {
+    *static_cast<void **>(block) = free_;
+    free_ = block;
+  }
+  // The block size.
+  auto size() const -> size_t;
+private:
+  auto grow_() -> void *;
+  void *free_ = nullptr;
+  char *next_ = nullptr; // The first unused block of the last slab.
+  char *end_ = nullptr;
+  std::vector<char *> slabs_;
+  size_t size_ = 0;
+  size_t slab_ = 0;
+};
+
+// Pools by block size shared by the allocators of related containers.
+// Slabs hold the given number of blocks up to POOL_SLAB_BYTES.
+class arena {
+public:
+  // Memory requests of all arenas and pool allocators to the system.
+  static size_t ALLOCATIONS;
+  explicit arena(size_t slab = POOL_SLAB);
+  arena(const arena &) = delete;
+  auto operator=(const arena &) -> arena & = delete;
+  virtual ~arena();
+  // The pool of blocks of a size, created on first use.
+  auto get(size_t) -> pool &;
+  // The pool of arrays of a size rounded up to a power of two, or nullptr
+  // for arrays larger than POOL_ARRAY bytes.
+  auto array(size_t) -> pool *;
+private:
+  std::vector<pool *> pools_;
+  size_t slab_ = 0;
+};
+
+// Allocate objects and arrays from an arena, large arrays from the system.
+// Default constructed allocators have no arena and allocate from the system.
+template<class T>
+class pool_allocator {
+  template<class U> friend class pool_allocator;
+public:
+  typedef T value_type;
+  pool_allocator() = default;
+  explicit pool_allocator(arena &a) : arena_(&a), pool_(&a.get(sizeof(T))) {
+  }
+  template<class U>
+  pool_allocator(const pool_allocator<U> &a) : arena_(a.arena_), pool_(a.arena_ ? &a.arena_->get(sizeof(T)) : nullptr) {
+  }
+  auto allocate(size_t n) -> T * {
+    auto p = n == 1 ? pool_ : arena_ ? arena_->array(n * sizeof(T)) : nullptr;
+    if (p) {
+      return static_cast<T *>(p->get());
+    }
+    ++arena::ALLOCATIONS;
+    return static_cast<T *>(::operator new(n * sizeof(T)));
+  }
+  void deallocate(T *block, size_t n) {
+    auto p = n == 1 ? pool_ : arena_ ? arena_->array(n * sizeof(T)) : nullptr;
+    if (p) {
+      p->put(block);
+    } else {
+      ::operator delete(block);
+    }
+  }
+  template<class U>
+  auto operator==(const pool_allocator<U> &a) const -> bool {
+    return arena_ == a.arena_;
+  }
+  template<class U>
+  auto operator!=(const pool_allocator<U> &a) const -> bool {
+    return arena_ != a.arena_;
+  }
+private:
+  arena *arena_ = nullptr;
+  pool *pool_ = nullptr;
+};
+
+}
+
+#endif //SDIS_POOL_H
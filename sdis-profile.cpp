@@ -0,0 +1,82 @@
+/*-
+ * Copyright (c) 2019 Rui Liu and Dominique Li <dominique.li@univ-tours.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id: log.h 998 2014-12-18 12:07:14Z li $
+ */
+
+#include <sstream>
+#include "sdis-profile.h"
+
+namespace sdistream {
+
+const char *profile::NAMES[profile::PHASES] = {"expiry", "lower", "repeat", "upper", "index"};
+bool profile::enabled = false;
+
+profile::profile(const size_t &dt) : dt_(dt) {
+}
+
+void profile::next(sink &out, bool report) {
+  if (!enabled) {
+    return;
+  }
+  enter(NONE);
+  if (report) {
+    std::ostringstream line;
+    line << "# Phases (ns/dt/visited/skipped)";
+    for (size_t p = 0; p < PHASES; ++p) {
+      auto &&c = tuple_[p];
+      line << " " << NAMES[p] << "=" << c.time << "/" << c.dt << "/" << c.visited << "/" << c.skipped;
+    }
+    out.comment(line.str());
+  }
+  for (size_t p = 0; p < PHASES; ++p) {
+    total_[p].time += tuple_[p].time;
+    total_[p].dt += tuple_[p].dt;
+    total_[p].visited += tuple_[p].visited;
+    total_[p].skipped += tuple_[p].skipped;
+    tuple_[p] = counters();
+  }
+  ++tuples_;
+}
+
+void profile::report(sink &out) const {
+  if (!enabled) {
+    return;
+  }
+  uint64_t time = 0;
+  for (auto &&c : total_) {
+    time += c.time;
+  }
+  for (size_t p = 0; p < PHASES; ++p) {
+    auto &&c = total_[p];
+    std::ostringstream line;
+    line << "# Phase " << NAMES[p] << ": time=" << c.time / 1e9 << " share=" << (time ? 100.0 * c.time / time : 0)
+         << "% dt=" << c.dt << " visited=" << c.visited << " skipped=" << c.skipped << " dt/tuple="
+         << (tuples_ ? 1.0 * c.dt / tuples_ : 0);
+    out.comment(line.str());
+  }
+}
+
+}
@@ -0,0 +1,107 @@
+/*-
+ * Copyright (c) 2019 Rui Liu and Dominique Li <dominique.li@univ-tours.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id: log.h 998 2014-12-18 12:07:14Z li $
+ */
+
+#ifndef SDIS_PROFILE_H
+#define SDIS_PROFILE_H
+
+#include <array>
+#include <cstdint>
+#include "sdis-sink.h"
+#include "timer.h"
+
+namespace sdistream {
+
+// Per-phase cost of the update pipeline: time, dominance tests, index
+// entries visited and entries skipped because they are not skyline
+// tuples. Phases are entered one after the other, entering a phase closes
+// the current one.
+class profile {
+public:
+  enum phase {
+    EXPIRY, // Expiry and promotion of dominated tuples.
+    LOWER, // Lower-bound dimension selection and scan, or the skyline block test.
+    REPEAT, // Upper-bound dimension selection and repeat-value scan.
+    UPPER, // Upper-bound scan, or the removal of the skyline tuples it dominates.
+    INDEX, // Dimensional index insert and erase.
+    PHASES,
+    NONE = PHASES
+  };
+  struct counters {
+    uint64_t time = 0;
+    size_t dt = 0;
+    size_t visited = 0;
+    size_t skipped = 0;
+  };
+  static const char *NAMES[PHASES];
+  // Whether phases are measured.
+  static bool enabled;
+  // Profile with a dominance test counter.
+  explicit profile(const size_t &);
+  // Enter a phase, or NONE to leave the current one.
+  inline void enter(phase p) {
+    if (!enabled) {
+      return;
+    }
+    auto now = timer::nanotime();
+    if (current_ != NONE) {
+      tuple_[current_].time += now - since_;
+      tuple_[current_].dt += dt_ - dt0_;
+    }
+    current_ = p;
+    since_ = now;
+    dt0_ = dt_;
+  }
+  // Skip a non-skyline index entry in the current phase.
+  inline void skip() {
+    if (enabled) {
+      ++tuple_[current_].skipped;
+    }
+  }
+  // Visit an index entry in the current phase.
+  inline void visit() {
+    if (enabled) {
+      ++tuple_[current_].visited;
+    }
+  }
+  // Close the current tuple, and write its phases to a sink if required.
+  void next(sink &, bool);
+  // Write the total cost of all phases to a sink.
+  void report(sink &) const;
+private:
+  phase current_ = NONE;
+  const size_t &dt_;
+  size_t dt0_ = 0;
+  uint64_t since_ = 0;
+  std::array<counters, PHASES> total_;
+  std::array<counters, PHASES> tuple_;
+  size_t tuples_ = 0;
+};
+
+}
+
+#endif //SDIS_PROFILE_H
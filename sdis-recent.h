@@ -0,0 +1,128 @@
+/*-
+ * Copyright (c) 2019 Rui Liu and Dominique Li <dominique.li@univ-tours.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id: log.h 998 2014-12-18 12:07:14Z li $
+ */
+
+#ifndef SDIS_RECENT_H
+#define SDIS_RECENT_H
+
+#ifndef RECENT_SLOTS
+#define RECENT_SLOTS 32
+#endif
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "sdis-dominance.h"
+#include "types.h"
+
+namespace sdistream {
+
+// Skyline points that recently dominated incoming tuples, stored column-wise
+// like a block, so that a tuple is tested against all of them by one batch
+// dominance kernel before any index scan. Slots are replaced in clock order,
+// skipping once the slots that found a dominated tuple since the hand last
+// passed. Empty slots are filled with NaN, which neither dominates nor is
+// dominated. Points must be erased when they leave the skyline.
+template<class K>
+class recent {
+public:
+  // Recent dominators of width values, with a dominance test counter.
+  recent(size_t width, size_t &dt)
+      : width_(width), dt_(dt), columns_(width * RECENT_SLOTS, NAN), keys_(RECENT_SLOTS), used_(RECENT_SLOTS),
+        referenced_(RECENT_SLOTS) {
+  }
+  // Find a recent point dominating a tuple.
+  auto probe(const value_t *tuple, K &dominating) -> bool {
+    ++probes_;
+    if (!size_) {
+      return false;
+    }
+    auto &&last = dominance::batch(columns_.data(), RECENT_SLOTS, RECENT_SLOTS, width_, tuple, mask_);
+    if (last == RECENT_SLOTS) {
+      dt_ += size_;
+      return false;
+    }
+    dt_ += RECENT_SLOTS - last < size_ ? RECENT_SLOTS - last : size_;
+    ++hits_;
+    referenced_[last] = true;
+    dominating = keys_[last];
+    return true;
+  }
+  // Keep a point that dominated a tuple.
+  void put(const K &key, const value_t *tuple) {
+    while (used_[hand_] && referenced_[hand_]) {
+      referenced_[hand_] = false;
+      hand_ = (hand_ + 1) % RECENT_SLOTS;
+    }
+    if (!used_[hand_]) {
+      used_[hand_] = true;
+      ++size_;
+    }
+    for (size_t i = 0; i < width_; ++i) {
+      columns_[i * RECENT_SLOTS + hand_] = tuple[i];
+    }
+    keys_[hand_] = key;
+    hand_ = (hand_ + 1) % RECENT_SLOTS;
+  }
+  // Forget a point that left the skyline.
+  void erase(const K &key) {
+    for (size_t p = 0; p < RECENT_SLOTS; ++p) {
+      if (used_[p] && keys_[p] == key) {
+        for (size_t i = 0; i < width_; ++i) {
+          columns_[i * RECENT_SLOTS + p] = NAN;
+        }
+        used_[p] = false;
+        referenced_[p] = false;
+        --size_;
+        return;
+      }
+    }
+  }
+  // The number of probes that found a dominating point.
+  auto hits() const -> size_t {
+    return hits_;
+  }
+  auto probes() const -> size_t {
+    return probes_;
+  }
+private:
+  size_t width_ = 0;
+  size_t &dt_;
+  std::vector<value_t> columns_; // Columns of RECENT_SLOTS values.
+  std::vector<K> keys_;
+  std::vector<bool> used_;
+  std::vector<bool> referenced_;
+  uint64_t mask_[(RECENT_SLOTS + 63) / 64] = {};
+  size_t hand_ = 0;
+  size_t size_ = 0;
+  size_t hits_ = 0;
+  size_t probes_ = 0;
+};
+
+}
+
+#endif //SDIS_RECENT_H
@@ -0,0 +1,140 @@
+/*-
+ * Copyright (c) 2019 Rui Liu and Dominique Li <dominique.li@univ-tours.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id: log.h 998 2014-12-18 12:07:14Z li $
+ */
+
+#ifndef SDIS_RING_H
+#define SDIS_RING_H
+
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <utility>
+
+namespace sdistream {
+
+// First in, first out queue of up to a fixed number of objects stored
+// contiguously in a circular array. Objects never move, so that pointers to
+// them stay valid until they are popped.
+template<class T>
+class ring {
+public:
+  // Objects from the first one to the last one.
+  class iterator {
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef T *pointer;
+    typedef T &reference;
+    iterator(ring *r, size_t n) : ring_(r), n_(n) {
+    }
+    auto operator*() const -> T & {
+      return (*ring_)[n_];
+    }
+    auto operator->() const -> T * {
+      return &(*ring_)[n_];
+    }
+    auto operator++() -> iterator & {
+      ++n_;
+      return *this;
+    }
+    auto operator==(const iterator &i) const -> bool {
+      return n_ == i.n_;
+    }
+    auto operator!=(const iterator &i) const -> bool {
+      return n_ != i.n_;
+    }
+  private:
+    ring *ring_;
+    size_t n_;
+  };
+  explicit ring(size_t capacity)
+      : capacity_(capacity ? capacity : 1), slots_(static_cast<T *>(::operator new(capacity_ * sizeof(T)))) {
+  }
+  ring(const ring &) = delete;
+  auto operator=(const ring &) -> ring & = delete;
+  virtual ~ring() {
+    while (size_) {
+      pop_front();
+    }
+    ::operator delete(slots_);
+  }
+  // Construct an object after the last one, the ring must not be full.
+  template<class... Args>
+  auto emplace_back(Args &&... args) -> T & {
+    assert(size_ < capacity_);
+    auto slot = slots_ + wrap_(head_ + size_);
+    new(slot) T(std::forward<Args>(args)...);
+    ++size_;
+    return *slot;
+  }
+  // Destroy the first object.
+  void pop_front() {
+    slots_[head_].~T();
+    head_ = wrap_(head_ + 1);
+    --size_;
+  }
+  // The n-th object from the first one.
+  auto operator[](size_t n) -> T & {
+    return slots_[wrap_(head_ + n)];
+  }
+  auto begin() -> iterator {
+    return iterator(this, 0);
+  }
+  auto end() -> iterator {
+    return iterator(this, size_);
+  }
+  auto front() -> T & {
+    return slots_[head_];
+  }
+  auto back() -> T & {
+    return slots_[wrap_(head_ + size_ - 1)];
+  }
+  auto capacity() const -> size_t {
+    return capacity_;
+  }
+  auto empty() const -> bool {
+    return size_ == 0;
+  }
+  auto size() const -> size_t {
+    return size_;
+  }
+private:
+  // Positions are less than twice the capacity.
+  auto wrap_(size_t n) const -> size_t {
+    return n < capacity_ ? n : n - capacity_;
+  }
+  size_t capacity_ = 0;
+  T *slots_ = nullptr;
+  size_t head_ = 0;
+  size_t size_ = 0;
+};
+
+}
+
+#endif //SDIS_RING_H
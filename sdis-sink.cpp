@@ -0,0 +1,188 @@
+/*-
+ * Copyright (c) 2019 Rui Liu and Dominique Li <dominique.li@univ-tours.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id: log.h 998 2014-12-18 12:07:14Z li $
+ */
+
+#include <cstring>
+#include "sdis-sink.h"
+
+namespace sdistream {
+
+// Header of a binary sink.
+struct binary_sink_header {
+  char magic[4] = {'S', 'D', 'I', 'R'};
+  uint32_t version = 1;
+  uint32_t size = sizeof(binary_record);
+  uint32_t reserved = 0;
+};
+
+static auto format_(char *p, size_t n, size_t v) -> int {
+  return snprintf(p, n, "%zu", v);
+}
+
+static auto format_(char *p, size_t n, double v) -> int {
+  return snprintf(p, n, "%g", v);
+}
+
+auto sink::create(const char *kind, const char *path, size_t interval) -> sink * {
+  bool text = !kind || !strcmp(kind, "text");
+  bool binary = kind && !strcmp(kind, "binary");
+  if (kind && !strcmp(kind, "null")) {
+    return new null_sink();
+  }
+  if (!text && !binary) {
+    return nullptr;
+  }
+  FILE *out = stdout;
+  if (path) {
+    out = fopen(path, binary ? "wb" : "w");
+    if (!out) {
+      return nullptr;
+    }
+  }
+  if (binary) {
+    return new binary_sink(out, interval);
+  }
+  return new text_sink(out, interval);
+}
+
+sink::sink(size_t interval) : interval_(interval) {
+}
+
+text_sink::text_sink(FILE *out, size_t interval) : sink(interval), buffer_(SINK_BUFFER), out_(out) {
+}
+
+text_sink::~text_sink() {
+  flush();
+  if (out_ != stdout) {
+    fclose(out_);
+  }
+}
+
+void text_sink::comment(const std::string &line) {
+  if (size_ + line.size() + 1 > buffer_.size()) {
+    flush();
+  }
+  if (line.size() + 1 > buffer_.size()) {
+    fwrite(line.data(), 1, line.size(), out_);
+    fputc('\n', out_);
+    return;
+  }
+  memcpy(&buffer_[size_], line.data(), line.size());
+  size_ += line.size();
+  buffer_[size_++] = '\n';
+}
+
+void text_sink::flush() {
+  if (size_) {
+    fwrite(buffer_.data(), 1, size_, out_);
+    size_ = 0;
+  }
+  fflush(out_);
+}
+
+void text_sink::write_(const record &r) {
+  // Large enough for a prefix, a stamp, a runtime and all values.
+  if (size_ + 32 * (record::VALUES + 3) > buffer_.size()) {
+    flush();
+  }
+  char *p = &buffer_[size_];
+  char *end = buffer_.data() + buffer_.size();
+  if (r.warm) {
+    *p++ = '#';
+    *p++ = ' ';
+  }
+  p += format_(p, end - p, r.stamp);
+  memcpy(p, r.dominated ? " - " : " + ", 3);
+  p += 3;
+  p += format_(p, end - p, r.runtime);
+  for (size_t i = 0; i < r.size; ++i) {
+    *p++ = ' ';
+    p += format_(p, end - p, r.values[i]);
+  }
+  *p++ = '\n';
+  size_ = p - buffer_.data();
+}
+
+binary_sink::binary_sink(FILE *out, size_t interval) : sink(interval), out_(out) {
+  buffer_.reserve(SINK_BUFFER / sizeof(binary_record));
+  binary_sink_header header;
+  fwrite(&header, sizeof(header), 1, out_);
+}
+
+binary_sink::~binary_sink() {
+  flush();
+  if (out_ != stdout) {
+    fclose(out_);
+  }
+}
+
+void binary_sink::comment(const std::string &line) {
+  // Keep summaries out of binary output.
+  FILE *log = out_ == stdout ? stderr : stdout;
+  fwrite(line.data(), 1, line.size(), log);
+  fputc('\n', log);
+}
+
+void binary_sink::flush() {
+  if (!buffer_.empty()) {
+    fwrite(buffer_.data(), sizeof(binary_record), buffer_.size(), out_);
+    buffer_.clear();
+  }
+  fflush(out_);
+}
+
+void binary_sink::write_(const record &r) {
+  binary_record b;
+  b.stamp = r.stamp;
+  b.runtime = r.runtime;
+  b.flags = (r.warm ? binary_record::WARM : 0) | (r.dominated ? binary_record::DOMINATED : 0);
+  b.size = (uint32_t) r.size;
+  for (size_t i = 0; i < r.size; ++i) {
+    b.values[i] = r.values[i];
+  }
+  buffer_.push_back(b);
+  if (buffer_.size() == buffer_.capacity()) {
+    flush();
+  }
+}
+
+null_sink::null_sink() : sink(0) {
+}
+
+void null_sink::comment(const std::string &line) {
+  fwrite(line.data(), 1, line.size(), stdout);
+  fputc('\n', stdout);
+}
+
+void null_sink::flush() {
+  fflush(stdout);
+}
+
+void null_sink::write_(const record &) {
+}
+
+}
@@ -0,0 +1,148 @@
+/*-
+ * Copyright (c) 2019 Rui Liu and Dominique Li <dominique.li@univ-tours.fr>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $Id: log.h 998 2014-12-18 12:07:14Z li $
+ */
+
+#ifndef SDIS_SINK_H
+#define SDIS_SINK_H
+
+#ifndef SINK_BUFFER
+#define SINK_BUFFER 65536
+#endif
+
+#include <cstdint>
+#include <cstdio>
+#include <initializer_list>
+#include <string>
+#include <vector>
+#include "types.h"
+
+namespace sdistream {
+
+// The result of processing a tuple.
+struct record {
+  static const size_t VALUES = 4;
+  bool warm = false; // The tuple arrived before the window was filled.
+  stamp_t stamp = 0;
+  bool dominated = false;
+  double runtime = 0;
+  size_t size = 0; // The number of values.
+  size_t values[VALUES] = {}; // Skyline size, then engine specific counters.
+};
+
+// A result record in binary sinks.
+struct binary_record {
+  static const uint32_t WARM = 1;
+  static const uint32_t DOMINATED = 2;
+  double stamp = 0;
+  double runtime = 0;
+  uint32_t flags = 0;
+  uint32_t size = 0;
+  uint64_t values[record::VALUES] = {};
+};
+
+// The destination of per-tuple results. Records are reported every
+// interval tuples, an interval of zero only reports the summary.
+class sink {
+public:
+  // Create a text, binary or null sink writing to a file or the standard
+  // output, return nullptr for an unknown sink.
+  static auto create(const char *, const char *, size_t) -> sink *;
+  explicit sink(size_t);
+  sink(const sink &) = delete;
+  auto operator=(const sink &) -> sink & = delete;
+  virtual ~sink() = default;
+  // Write a summary line.
+  virtual void comment(const std::string &) = 0;
+  // Flush buffered results.
+  virtual void flush() = 0;
+  // Report the result of a tuple, return true if it was written.
+  inline auto put(bool warm, stamp_t stamp, bool dominated, double runtime,
+                  std::initializer_list<size_t> values) -> bool {
+    if (!interval_ || ++count_ % interval_) {
+      return false;
+    }
+    record r;
+    r.warm = warm;
+    r.stamp = stamp;
+    r.dominated = dominated;
+    r.runtime = runtime;
+    for (auto &&v : values) {
+      if (r.size < record::VALUES) {
+        r.values[r.size++] = v;
+      }
+    }
+    write_(r);
+    return true;
+  }
+protected:
+  virtual void write_(const record &) = 0;
+  size_t count_ = 0;
+  size_t interval_ = 1;
+};
+
+// Buffered text lines, as "[# ]STAMP +|- RUNTIME VALUES...".
+class text_sink : public sink {
+public:
+  text_sink(FILE *, size_t);
+  ~text_sink() override;
+  void comment(const std::string &) override;
+  void flush() override;
+protected:
+  void write_(const record &) override;
+private:
+  std::vector<char> buffer_;
+  FILE *out_ = nullptr;
+  size_t size_ = 0;
+};
+
+// Fixed-size binary records after a small header.
+class binary_sink : public sink {
+public:
+  binary_sink(FILE *, size_t);
+  ~binary_sink() override;
+  void comment(const std::string &) override;
+  void flush() override;
+protected:
+  void write_(const record &) override;
+private:
+  std::vector<binary_record> buffer_;
+  FILE *out_ = nullptr;
+};
+
+// Discard all results but the summary.
+class null_sink : public sink {
+public:
+  null_sink();
+  void comment(const std::string &) override;
+  void flush() override;
+protected:
+  void write_(const record &) override;
+};
+
+}
+
+#endif //SDIS_SINK_H
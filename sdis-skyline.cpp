@@ -26,6 +26,10 @@
  * $Id: log.h 998 2014-12-18 12:07:14Z li $
  */
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <new>
 #include "sdis-skyline.h"
 
 namespace sdistream {
@@ -33,77 +37,232 @@ namespace sdistream {
 size_t skyline::DT = 0;
 
 auto operator<<(std::ostream &out, const skyline &skyline) -> std::ostream & {
-  for (auto &&tree : skyline.tree_) {
-    for (auto &&s: tree) {
-      out << s.first << std::endl;
+  for (auto &&s : skyline.slots_) {
+    if (s.tail) {
+      out << s.id << std::endl;
     }
   }
   return out;
 }
 
+skyline::skyline()
+    : lists_(&arena_.get(sizeof(points))), merge_(points::allocator_type(arena_)), slots_(SKYLINE_SLOTS),
+      mask_(SKYLINE_SLOTS - 1) {
+}
+
+skyline::~skyline() {
+  for (auto &&s : slots_) {
+    if (s.tail) {
+      s.tail->~points();
+    }
+  }
+}
+
 auto skyline::add(const index_t &s) -> skyline & {
-  auto &&it = tree_[slice_(s)].find(s);
-  if (it != tree_[slice_(s)].end()) {
+  if (find_(s)) {
     return *this;
   }
-  std::vector<index_t> v;
-  tree_[slice_(s)].insert(std::make_pair(s, v));
+  insert_(s);
   ++count_;
   return *this;
 }
 
 auto skyline::append(const index_t &s, const index_t &p) -> skyline & {
-  auto &&it = tree_[slice_(s)].find(s);
-  if (it == tree_[slice_(s)].end()) {
-    std::vector<index_t> v;
-    v.push_back(p);
-    tree_[slice_(s)].insert(std::make_pair(s, v));
+  auto it = find_(s);
+  if (!it) {
+    it = insert_(s);
+  }
+  auto &&tail = *it->tail;
+  room_(tail);
+  if (tail.empty() || tail.back() < p) {
+    tail.push_back(p);
     return *this;
   }
-  it->second.push_back(p);
+  auto at = std::lower_bound(tail.begin(), tail.end(), p);
+  if (at == tail.end() || *at != p) {
+    tail.insert(at, p);
+  }
   return *this;
 }
 
 auto skyline::contains(const index_t &p) -> bool {
-  return tree_[slice_(p)].count(p);
+  return find_(p) != nullptr;
+}
+
+void skyline::expire(const index_t &id) {
+  horizon_ = id;
 }
 
-auto skyline::get(const index_t &s) -> std::vector<index_t> & {
-  auto &&it = tree_[slice_(s)].find(s);
-  if (it == tree_[slice_(s)].end()) {
+auto skyline::get(const index_t &s) -> points & {
+  auto it = find_(s);
+  if (!it) {
     return empty_;
   }
-  return it->second;
+  prune_(*it->tail);
+  return *it->tail;
 }
 
 auto skyline::move(const index_t &s1, const index_t &s2) -> skyline & {
-  auto &&it1 = tree_[slice_(s1)].find(s1);
-  if (it1 == tree_[slice_(s1)].end()) {
+  auto it1 = find_(s1);
+  if (!it1) {
     return *this;
   }
-  auto &&it2 = tree_[slice_(s2)].find(s2);
-  if (it2 == tree_[slice_(s2)].end()) {
+  auto it2 = find_(s2);
+  if (!it2) {
     return *this;
   }
-  it2->second.push_back(s1);
-  it2->second.insert(it2->second.end(), it1->second.begin(), it1->second.end());
-  tree_[slice_(s1)].erase(it1);
+  // Merge the demoted point and its list into the list of its dominator.
+  auto &&tail1 = *it1->tail;
+  auto &&tail2 = *it2->tail;
+  prune_(tail1);
+  prune_(tail2);
+  tail1.insert(std::lower_bound(tail1.begin(), tail1.end(), s1), s1);
+  merge_.clear();
+  std::set_union(tail2.begin(), tail2.end(), tail1.begin(), tail1.end(), std::back_inserter(merge_));
+  tail2.swap(merge_);
+  erase_(it1);
   --count_;
   return *this;
 }
 
 auto skyline::remove(const index_t &s) -> skyline & {
-  tree_[slice_(s)].erase(s);
+  auto it = find_(s);
+  if (it) {
+    erase_(it);
+  }
   --count_;
   return *this;
 }
 
+void skyline::reserve(size_t n) {
+  size_t capacity = slots_.size();
+  while (capacity < n) {
+    capacity *= 2;
+  }
+  if (capacity > slots_.size()) {
+    rehash_(capacity);
+  }
+}
+
 auto skyline::size() -> size_t {
   return count_;
 }
 
-auto skyline::slice_(index_t index) -> size_t {
-  return (int) index % SLICE;
+auto skyline::tail_live() const -> size_t {
+  size_t n = 0;
+  for (auto &&s : slots_) {
+    if (s.tail) {
+      n += s.tail->end() - std::lower_bound(s.tail->begin(), s.tail->end(), horizon_);
+    }
+  }
+  return n;
+}
+
+auto skyline::tail_total() const -> size_t {
+  size_t n = 0;
+  for (auto &&s : slots_) {
+    if (s.tail) {
+      n += s.tail->size();
+    }
+  }
+  return n;
+}
+
+#ifndef WITH_TIME_WINDOW
+
+auto skyline::hash_(index_t id) -> size_t {
+  return id;
+}
+
+#else
+
+// Stamps differ in their low mantissa bits, mix them into the high bits.
+auto skyline::hash_(index_t id) -> size_t {
+  uint64_t bits;
+  std::memcpy(&bits, &id, sizeof(bits));
+  bits *= 0x9e3779b97f4a7c15ULL;
+  return static_cast<size_t>(bits ^ bits >> 32);
+}
+
+#endif
+
+auto skyline::find_(index_t id) -> skyline::slot * {
+  for (size_t i = hash_(id) & mask_;; i = (i + 1) & mask_) {
+    auto &&s = slots_[i];
+    if (!s.tail) {
+      return nullptr;
+    }
+    if (s.id == id) {
+      return &s;
+    }
+  }
+}
+
+// Insert a point that is not in the table.
+auto skyline::insert_(index_t id) -> skyline::slot * {
+  if (2 * (size_ + 1) > slots_.size()) {
+    rehash_(2 * slots_.size());
+  }
+  size_t i = hash_(id) & mask_;
+  while (slots_[i].tail) {
+    i = (i + 1) & mask_;
+  }
+  auto &&s = slots_[i];
+  s.id = id;
+  s.tail = new(lists_->get()) points(points::allocator_type(arena_));
+  ++size_;
+  return &s;
+}
+
+// Shift back the following slots of the run that may take the erased slot.
+void skyline::erase_(skyline::slot *s) {
+  s->tail->~points();
+  lists_->put(s->tail);
+  size_t i = s - slots_.data();
+  for (size_t j = (i + 1) & mask_; slots_[j].tail; j = (j + 1) & mask_) {
+    size_t k = hash_(slots_[j].id) & mask_;
+    // Keep slots whose home lies cyclically in (i, j].
+    if (i <= j ? i < k && k <= j : i < k || k <= j) {
+      continue;
+    }
+    slots_[i] = slots_[j];
+    i = j;
+  }
+  slots_[i].tail = nullptr;
+  --size_;
+}
+
+// Drop the expired prefix of a list.
+void skyline::prune_(skyline::points &tail) const {
+  if (!tail.empty() && tail.front() < horizon_) {
+    tail.erase(tail.begin(), std::lower_bound(tail.begin(), tail.end(), horizon_));
+  }
+}
+
+// Prune a full list before it grows, and grow it only when more than half
+// of it is live, so that appending stays amortized constant time.
+void skyline::room_(skyline::points &tail) const {
+  if (tail.size() == tail.capacity()) {
+    prune_(tail);
+    if (2 * tail.size() > tail.capacity()) {
+      tail.reserve(2 * tail.capacity());
+    }
+  }
+}
+
+void skyline::rehash_(size_t capacity) {
+  std::vector<slot> slots(capacity);
+  slots_.swap(slots);
+  mask_ = capacity - 1;
+  for (auto &&s : slots) {
+    if (s.tail) {
+      size_t i = hash_(s.id) & mask_;
+      while (slots_[i].tail) {
+        i = (i + 1) & mask_;
+      }
+      slots_[i] = s;
+    }
+  }
 }
 
 }
@@ -29,43 +29,80 @@
 #ifndef SDIS_SKYLINE_H
 #define SDIS_SKYLINE_H
 
-#ifndef SLICE
-#define SLICE 32
+#ifndef SKYLINE_SLOTS
+#define SKYLINE_SLOTS 64
 #endif
 
-#include <array>
 #include <iostream>
-#include <unordered_map>
 #include <vector>
+#include "sdis-dominance.h"
+#include "sdis-pool.h"
 #include "types.h"
 
 namespace sdistream {
 
+// Skyline points and the points they dominate in a flat open addressing
+// table with linear probing, kept at most half full. Count window ids are
+// their own hash, so that a table larger than the window addresses them
+// directly, time window ids are hashed. Erased slots are refilled by
+// shifting back the following slots instead of leaving tombstones.
+// Dominated points are kept in pooled lists that do not move with slots,
+// sorted by id without duplicates. Ids are generations: expired points are
+// dropped from a list whenever it is read or merged, and before it grows.
 class skyline {
   friend auto operator<<(std::ostream &, const skyline &) -> std::ostream &;
 public:
+  typedef std::vector<index_t, pool_allocator<index_t>> points;
   static size_t DT;
-  skyline() = default;
-  virtual ~skyline() = default;
+  skyline();
+  skyline(const skyline &) = delete;
+  auto operator=(const skyline &) -> skyline & = delete;
+  virtual ~skyline();
   // Add a skyline point to d-tree.
   auto add(const index_t &) -> skyline &;
   // The first skyline point dominates the second point.
   auto append(const index_t &, const index_t &) -> skyline &;
   // Check whether a point is skyline point.
   auto contains(const index_t &) -> bool;
-  // Get all dominated points of a skyline point.
-  auto get(const index_t &) -> std::vector<index_t> &;
+  // Points older than an id have expired.
+  void expire(const index_t &);
+  // Get all unexpired dominated points of a skyline point.
+  auto get(const index_t &) -> points &;
   // Move the first skyline point to the second skyline point.
   auto move(const index_t &, const index_t &) -> skyline &;
   // Remove a skyline point.
   auto remove(const index_t &) -> skyline &;
+  // Address a number of consecutive ids directly, the size of a count
+  // window.
+  void reserve(size_t);
   // The number of skyline points.
   auto size() -> size_t;
+  // The number of unexpired dominated points in all lists.
+  auto tail_live() const -> size_t;
+  // The number of dominated points in all lists.
+  auto tail_total() const -> size_t;
 private:
-  static auto slice_(index_t) -> size_t;
+  // An empty slot has no points.
+  struct slot {
+    index_t id = 0;
+    points *tail = nullptr;
+  };
+  static auto hash_(index_t) -> size_t;
+  auto find_(index_t) -> slot *;
+  auto insert_(index_t) -> slot *;
+  void erase_(slot *);
+  void prune_(points &) const;
+  void room_(points &) const;
+  void rehash_(size_t);
   size_t count_ = 0;
-  std::vector<index_t> empty_;
-  std::array<std::unordered_map<index_t, std::vector<index_t>>, SLICE> tree_;
+  index_t horizon_ = 0;
+  arena arena_;
+  pool *lists_ = nullptr;
+  points empty_;
+  points merge_;
+  std::vector<slot> slots_;
+  size_t mask_ = 0;
+  size_t size_ = 0; // Occupied slots.
 };
 
 template<class V>
@@ -84,6 +121,13 @@ auto dominate(V *row1, V *row2, size_t width) -> bool {
   return dominating;
 }
 
+// Rows of values are compared by the vectorized kernels.
+template<>
+inline auto dominate<value_t>(value_t *row1, value_t *row2, size_t width) -> bool {
+  ++skyline::DT;
+  return dominance::test(row1, row2, width);
+}
+
 }
 
 #endif //SDIS_SKYLINE_H
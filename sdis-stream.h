@@ -36,6 +36,7 @@
 #include <array>
 #include <cstring>
 #include <iostream>
+#include <vector>
 #include "types.h"
 
 namespace sdistream {
@@ -59,6 +60,25 @@ auto input(IN &in, size_t width, value_t *buffer) -> bool {
   return true;
 }
 
+// Tuple input buffer of D values, or of the width given at run time for D = 0.
+template<size_t D>
+class row {
+public:
+  explicit row(size_t) {}
+  auto data() -> value_t * { return values_.data(); }
+private:
+  std::array<value_t, D> values_{};
+};
+
+template<>
+class row<0> {
+public:
+  explicit row(size_t width) : values_(width) {}
+  auto data() -> value_t * { return values_.data(); }
+private:
+  std::vector<value_t> values_;
+};
+
 }
 
 #endif //SDIX_STREAM_H
@@ -36,34 +36,46 @@ auto timer::microtime() -> double {
   return t.tv_sec + t.tv_usec / 1000000.0;
 }
 
+auto timer::nanotime() -> uint64_t {
+  struct timespec t{};
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (uint64_t) t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
 auto timer::now() -> time_t {
   return time(nullptr);
 }
 
+auto timer::elapsed() -> uint64_t {
+  return (stop_ ? stop_ : nanotime()) - start_;
+}
+
 auto timer::reset() -> double {
   stop_ = 0;
   total_ = 0;
-  return start_ = clock();
+  start_ = nanotime();
+  return start_ / 1e9;
 }
 
 auto timer::runtime() -> double {
   if (!stop_) {
-    stop_ = clock();
+    stop_ = nanotime();
   }
-  return (double) (stop_ - start_) / CLOCKS_PER_SEC;
+  return (stop_ - start_) / 1e9;
 }
 
 auto timer::start() -> double {
   stop_ = 0;
-  return start_ = clock();
+  start_ = nanotime();
+  return start_ / 1e9;
 }
 
 auto timer::stop() -> double {
-  stop_ = clock();
+  stop_ = nanotime();
   total_ += stop_ - start_;
-  return stop_;
+  return stop_ / 1e9;
 }
 
 auto timer::total() -> double {
-  return (double) total_ / CLOCKS_PER_SEC;
+  return total_ / 1e9;
 }
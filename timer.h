@@ -29,22 +29,26 @@
 #ifndef TIMER_H_
 #define TIMER_H_
 
+#include <cstdint>
 #include <ctime>
 
+// Wall-clock timer on the monotonic clock, with nanosecond resolution.
 class timer {
 public:
   static auto microtime() -> double;
+  static auto nanotime() -> uint64_t;
   static auto now() -> time_t;
   timer() = default;
+  auto elapsed() -> uint64_t;
   auto reset() -> double;
   auto runtime() -> double;
   auto start() -> double;
   auto stop() -> double;
   auto total() -> double;
 private:
-  clock_t start_ = 0;
-  clock_t stop_ = 0;
-  clock_t total_ = 0;
+  uint64_t start_ = 0;
+  uint64_t stop_ = 0;
+  uint64_t total_ = 0;
 };
 
 #endif //TIMER_H_